@@ -0,0 +1,146 @@
+/* arena.h
+ * Arena class template to allocate objects of one type in large chunks, and
+ * StringArena class to store strings back to back. Both hand out 32-bit
+ * handles which stay valid until the arena is cleared, and both free all of
+ * their memory at once
+ *  Author:          Dónal Murray
+ *  Date:            17/10/26
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstdint>     // uint32_t handles
+#include <cstddef>     // size_t
+#include <cstring>     // memcpy
+#include <new>         // placement new
+#include <string>      // string type
+#include <string_view> // strings to store
+#include <type_traits> // is_trivially_destructible
+#include <utility>     // forward
+#include <vector>      // vector container
+
+using namespace std;
+
+template <class T> class Arena {
+private:
+  // objects are stored in chunks which never move, so pointers into the arena
+  // stay valid as it grows
+  static const uint32_t chunk_bits{10};
+  static const uint32_t chunk_size{1u << chunk_bits};
+
+  vector<T *> chunks; // allocated chunks
+  uint32_t count;     // number of objects created
+
+public:
+  typedef uint32_t Handle;
+
+  // constructor
+  Arena() : count{0} {}
+  // the objects cannot be shared between arenas
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  // destructor
+  ~Arena() { clear(); }
+
+  // construct a new object in the arena and return its handle (constructor
+  // arguments)
+  template <class... Args> Handle create(Args &&... args) {
+    if (count == chunks.size() * chunk_size) {
+      // all of the chunks are full, allocate another
+      chunks.push_back((T *)::operator new(chunk_size * sizeof(T)));
+    }
+    new (chunks[count >> chunk_bits] + (count & (chunk_size - 1)))
+        T(forward<Args>(args)...);
+    return count++;
+  }
+
+  // return the object with this handle (handle)
+  T *operator[](const Handle &handle) const {
+    return chunks[handle >> chunk_bits] + (handle & (chunk_size - 1));
+  }
+
+  // number of objects in the arena
+  uint32_t size() const { return count; }
+
+  // destroy every object and free the chunks. Objects with trivial destructors
+  // are not visited at all, so this only costs one free per chunk
+  void clear() {
+    if (!is_trivially_destructible<T>::value) {
+      for (uint32_t i{0}; i < count; i++) {
+        (*this)[i]->~T();
+      }
+    }
+    for (auto it : chunks) {
+      ::operator delete(it);
+    }
+    chunks.clear();
+    count = 0;
+  }
+};
+
+class StringArena {
+private:
+  // strings are stored back to back in blocks which never move, so views of
+  // them stay valid as the arena grows. Longer strings get a block each
+  static const size_t block_size{1 << 16};
+
+  vector<char *> blocks;        // allocated blocks
+  size_t used;                  // bytes used in the last block
+  vector<string_view> contents; // each string, followed by a nul
+
+public:
+  typedef uint32_t Handle;
+
+  // constructor
+  StringArena() : used{block_size} {}
+  // the strings cannot be shared between arenas
+  StringArena(const StringArena &) = delete;
+  StringArena &operator=(const StringArena &) = delete;
+  // destructor
+  ~StringArena() { clear(); }
+
+  // copy a string into the arena and return its handle (string). The space
+  // used by strings is only reclaimed when the arena is cleared
+  Handle add(const string_view &str) {
+    const size_t length{str.length() + 1};
+    char *start;
+    if (length > block_size) {
+      // a block of its own, before the last block so that is still filled
+      start = (char *)::operator new(length);
+      blocks.insert(blocks.end() - (blocks.empty() ? 0 : 1), start);
+    } else {
+      if (used + length > block_size) {
+        blocks.push_back((char *)::operator new(block_size));
+        used = 0;
+      }
+      start = blocks.back() + used;
+      used += length;
+    }
+    memcpy(start, str.data(), str.length());
+    start[str.length()] = '\0';
+    contents.push_back(string_view{start, str.length()});
+    return contents.size() - 1;
+  }
+
+  // return the nul terminated string with this handle, which stays valid
+  // until the arena is cleared (handle)
+  const char *operator[](const Handle &handle) const {
+    return contents[handle].data();
+  }
+  // return a view of the string with this handle (handle)
+  string_view view(const Handle &handle) const { return contents[handle]; }
+
+  // free every string
+  void clear() {
+    for (auto it : blocks) {
+      ::operator delete(it);
+    }
+    blocks.clear();
+    used = block_size;
+    contents.clear();
+    contents.shrink_to_fit();
+  }
+};
+
+#endif
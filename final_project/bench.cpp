@@ -0,0 +1,502 @@
+/* bench.cpp: microbenchmarks for the circuit core
+ * Times complex arithmetic, component and circuit impedances, the sweep and
+ * library evaluators and project save/load on random series/parallel trees.
+ * Each benchmark prints one JSON object per line:
+ *    {"name":..., "params":{...}, "ns_per_op":..., "allocs_per_op":...,
+ *     "ops_per_s":..., "bytes_per_s":...}
+ * Usage: bench_output [size depth sharing] to time one tree configuration
+ *
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#include <chrono>    // timing
+#include <cmath>     // pow
+#include <cstdio>    // remove
+#include <fstream>   // size of binary projects
+#include <iostream>  // std io
+#include <random>    // mt19937
+#include <sstream>   // string streams for text projects
+#include <string>    // names
+#include <vector>    // vector container
+
+#include "binaryproject.h"  // binary project files
+#include "capacitor.h"      // capacitor class
+#include "circuit.h"        // circuit class
+#include "complex.h"        // complex class
+#include "component.h"      // component base class
+#include "evaluator.h"      // parallel evaluation of the circuit library
+#include "fixedcircuit.h"   // compile-time circuits
+#include "inductor.h"       // inductor class
+#include "library.h"        // libs namespace
+#include "libraryversion.h" // forked libraries
+#include "montecarlo.h"     // tolerance analysis
+#include "netlist.h"        // nodal analysis
+#include "optimiser.h"      // simplified circuits
+#include "project.h"        // text project files
+#include "renderer.h"       // buffered output
+#include "resistor.h"       // resistor class
+#include "sensitivity.h"    // derivatives of impedances
+#include "snapshot.h"       // immutable circuits
+#include "stats.h"          // allocation counter
+#include "sweep.h"          // frequency sweeps
+#include "sweepexport.h"    // sweeps of the whole library
+#include "transient.h"      // time domain simulation
+
+using namespace std;
+
+namespace {
+//-----------------------------------------------------------------------------
+//---timing
+//-----------------------------------------------------------------------------
+// minimum time to spend on each benchmark
+const double min_time{0.2};
+// results are added here so that the work cannot be optimised away
+volatile double sink;
+
+// time a benchmark and print its result (name, parameters as a JSON object,
+// function doing some work and returning the number of operations done,
+// bytes processed per operation)
+template <class F>
+void run(const string &name, const string &params, F body,
+         const double &bytes_per_op = 0) {
+  body(); // warm up
+  size_t ops{0};
+  const size_t allocs_before{stats::total(stats::allocations)};
+  auto start = chrono::steady_clock::now();
+  double elapsed{0};
+  do {
+    ops += body();
+    elapsed = chrono::duration<double>(chrono::steady_clock::now() - start)
+                  .count();
+  } while (elapsed < min_time);
+  const size_t allocs{stats::total(stats::allocations) - allocs_before};
+  cout << "{\"name\":\"" << name << "\",\"params\":" << params
+       << ",\"ns_per_op\":" << elapsed * 1e9 / ops
+       << ",\"allocs_per_op\":" << (double)allocs / ops
+       << ",\"ops_per_s\":" << ops / elapsed;
+  if (bytes_per_op > 0) {
+    cout << ",\"bytes_per_s\":" << bytes_per_op * ops / elapsed;
+  }
+  cout << "}" << endl;
+}
+
+//-----------------------------------------------------------------------------
+//---random circuits
+//-----------------------------------------------------------------------------
+// random component with a value between 1 and 1000 (random numbers)
+Component *random_component(mt19937 &rng) {
+  uniform_real_distribution<double> value(1, 1000);
+  switch (rng() % 3) {
+  case 0:
+    return libs::make<Resistor>(value(rng));
+  case 1:
+    return libs::make<Capacitor>(value(rng));
+  default:
+    return libs::make<Inductor>(value(rng));
+  }
+}
+
+// build a random circuit with this many levels of subcircuits below it
+// (levels, children of each circuit, sharing, random numbers, circuits built
+// so far at each level)
+Circuit *random_circuit(const int &levels, const int &width,
+                        const double &sharing, mt19937 &rng,
+                        vector<vector<Circuit *>> &built) {
+  Circuit *circ;
+  if (rng() % 2 == 0) {
+    circ = libs::make<Series>(50);
+  } else {
+    circ = libs::make<Parallel>(50);
+  }
+  uniform_real_distribution<double> chance(0, 1);
+  for (int i{0}; i < width; i++) {
+    if (levels == 1) {
+      Component *comp{random_component(rng)};
+      libs::insert(comp);
+      circ->add_component(comp);
+    } else if (!built[levels - 1].empty() && (chance(rng) < sharing)) {
+      // reuse a circuit which is already in the tree
+      vector<Circuit *> &choices{built[levels - 1]};
+      circ->add_subcircuit(choices[rng() % choices.size()]);
+    } else {
+      circ->add_subcircuit(
+          random_circuit(levels - 1, width, sharing, rng, built));
+    }
+  }
+  // subcircuits are inserted before the circuits which contain them
+  libs::insert(circ);
+  built[levels].push_back(circ);
+  return circ;
+}
+
+// random series/parallel tree with about size components when nothing is
+// shared, depth levels of circuits and a fraction sharing of subcircuits
+// reused from elsewhere in the tree (size, depth, sharing, seed). The tree is
+// added to the libraries and its root is returned
+Circuit *generate_tree(const int &size, const int &depth,
+                       const double &sharing, const unsigned &seed) {
+  mt19937 rng(seed);
+  const int width{max(2, (int)round(pow(size, 1.0 / depth)))};
+  vector<vector<Circuit *>> built(depth + 1);
+  return random_circuit(depth, width, sharing, rng, built);
+}
+
+//-----------------------------------------------------------------------------
+//---benchmarks
+//-----------------------------------------------------------------------------
+// complex arithmetic on arrays of numbers
+void bench_complex() {
+  const size_t n{1024};
+  mt19937 rng(1);
+  uniform_real_distribution<double> value(-100, 100);
+  vector<Complex> a(n);
+  vector<Complex> b(n);
+  vector<Complex> c(n);
+  for (size_t i{0}; i < n; i++) {
+    a[i] = Complex{value(rng), value(rng)};
+    b[i] = Complex{value(rng), value(rng)};
+  }
+  const string params{"{\"n\":1024}"};
+  run("complex_add", params, [&]() {
+    for (size_t i{0}; i < n; i++) {
+      c[i] = a[i] + b[i];
+    }
+    sink = c[n - 1].get_real();
+    return n;
+  });
+  run("complex_multiply", params, [&]() {
+    for (size_t i{0}; i < n; i++) {
+      c[i] = a[i] * b[i];
+    }
+    sink = c[n - 1].get_real();
+    return n;
+  });
+  run("complex_divide", params, [&]() {
+    for (size_t i{0}; i < n; i++) {
+      c[i] = a[i] / b[i];
+    }
+    sink = c[n - 1].get_real();
+    return n;
+  });
+  run("complex_modulus", params, [&]() {
+    double total{0};
+    for (size_t i{0}; i < n; i++) {
+      total += a[i].modulus();
+    }
+    sink = total;
+    return n;
+  });
+}
+
+// impedance of each kind of component
+template <class T> void bench_component(const string &name) {
+  const size_t n{1024};
+  mt19937 rng(2);
+  uniform_real_distribution<double> value(1, 1000);
+  vector<Component *> components(n);
+  for (auto &it : components) {
+    it = libs::make<T>(value(rng));
+  }
+  run(name, "{\"n\":1024}", [&]() {
+    Complex total;
+    for (auto it : components) {
+      total = total + it->get_impedance(50);
+    }
+    sink = total.get_real();
+    return n;
+  });
+}
+
+// impedance of a fixed topology at 256 frequencies, as a runtime circuit
+// (virtual calls), a compiled sweep and a compile-time circuit (name, fixed
+// circuit)
+template <class T> void bench_fixed(const string &name, const T &fixed) {
+  Circuit *circ{fixed.to_circuit(50)};
+  Sweep sweep(*circ);
+  vector<double> freqs(256);
+  vector<double> re(freqs.size());
+  vector<double> im(freqs.size());
+  for (size_t i{0}; i < freqs.size(); i++) {
+    freqs[i] = 10 + i;
+  }
+  const string params{"{\"frequencies\":256}"};
+  run(name + "_runtime", params, [&]() {
+    for (size_t i{0}; i < freqs.size(); i++) {
+      circ->set_frequency(freqs[i]);
+      const Complex z{circ->get_impedance()};
+      re[i] = z.get_real();
+      im[i] = z.get_imaginary();
+    }
+    sink = re[0];
+    return freqs.size();
+  });
+  run(name + "_sweep", params, [&]() {
+    sweep.evaluate(freqs.data(), re.data(), im.data(), freqs.size());
+    sink = re[0];
+    return freqs.size();
+  });
+  run(name + "_template", params, [&]() {
+    fixed.evaluate(freqs.data(), re.data(), im.data(), freqs.size());
+    sink = re[0];
+    return freqs.size();
+  });
+}
+
+// evaluators, save and load on a random tree (size, depth, sharing)
+void bench_tree(const int &size, const int &depth, const double &sharing) {
+  libs::clear();
+  Circuit *root{generate_tree(size, depth, sharing, 3)};
+  ostringstream params_stream;
+  params_stream << "{\"size\":" << size << ",\"depth\":" << depth
+                << ",\"sharing\":" << sharing
+                << ",\"components\":" << libs::component_lib.size()
+                << ",\"circuits\":" << libs::circuit_lib.size() << "}";
+  const string params{params_stream.str()};
+
+  // alternate between two frequencies so that every cache is invalid
+  double freq{50};
+  auto next_frequency = [&]() {
+    freq = freq == 50 ? 60 : 50;
+    root->set_frequency(freq);
+  };
+  run("circuit_get_impedance_cold", params, [&]() {
+    next_frequency();
+    sink = root->get_impedance().get_real();
+    return 1;
+  });
+  run("circuit_get_impedance_cached", params, [&]() {
+    sink = root->get_impedance().get_real();
+    return 1;
+  });
+  run("evaluate_library", params, [&]() {
+    next_frequency();
+    sink = evaluate_library(libs::circuit_lib).back().get_real();
+    return 1;
+  });
+  Sweep sweep(*root);
+  vector<double> freqs(256);
+  vector<double> re(freqs.size());
+  vector<double> im(freqs.size());
+  for (size_t i{0}; i < freqs.size(); i++) {
+    freqs[i] = 10 + i;
+  }
+  run("sweep_evaluate_per_frequency", params, [&]() {
+    sweep.evaluate(freqs.data(), re.data(), im.data(), freqs.size());
+    sink = re[0];
+    return freqs.size();
+  });
+
+  // sweep of the whole library streamed to a file in each format
+  for (auto format : {sweep_format::csv, sweep_format::binary}) {
+    const string export_filename{format == sweep_format::csv ? "bench.csv"
+                                                             : "bench.acs"};
+    auto export_library = [&]() {
+      export_sweep(libs::circuit_lib, freqs, export_filename, format);
+      ifstream file(export_filename, ios::binary | ios::ate);
+      return (size_t)file.tellg();
+    };
+    run(format == sweep_format::csv ? "export_sweep_csv"
+                                    : "export_sweep_binary",
+        params,
+        [&]() {
+          export_library();
+          return 1;
+        },
+        export_library());
+    remove(export_filename.c_str());
+  }
+
+  run("impedance_sensitivity", params, [&]() {
+    next_frequency();
+    sink = impedance_sensitivity(*root).size();
+    return 1;
+  });
+
+  run("snapshot_take", params, [&]() {
+    sink = LibrarySnapshot::take()->get_circuits().size();
+    return 1;
+  });
+  const SnapshotPtr snapshot{CircuitSnapshot::take(*root)};
+  run("snapshot_impedance_at", params, [&]() {
+    freq = freq == 50 ? 60 : 50;
+    sink = snapshot->impedance_at(freq).get_real();
+    return 1;
+  });
+
+  const LibraryVersion version{LibraryVersion::take()};
+  // a component deep in the tree, so each edit copies a whole path
+  const string edited_label{libs::component_lib.front()->get_label()};
+  run("version_fork_edit", params, [&]() {
+    freq = freq == 50 ? 60 : 50;
+    sink = version.with_value(edited_label, freq).get_no_components();
+    return 1;
+  });
+  run("version_impedances_at", params, [&]() {
+    freq = freq == 50 ? 60 : 50;
+    sink = version.impedances_at(freq).size();
+    return 1;
+  });
+
+  run("optimise", params, [&]() {
+    sink = OptimisedCircuit{*root}.get_report().circuits_after;
+    return 1;
+  });
+  const OptimisedCircuit optimised{*root};
+  run("optimised_impedance", params, [&]() {
+    next_frequency();
+    sink = optimised.impedance(freq).get_real();
+    return 1;
+  });
+
+  // time domain simulation of the whole network, one step at a time and
+  // streamed to a file
+  Netlist net{*root};
+  TransientAnalysis transient{net, 1, 0};
+  transient.prepare(1e-6, TransientAnalysis::trapezoidal);
+  run("transient_step", params, [&]() {
+    sink = transient.step(1);
+    return 1;
+  });
+  const string waveform_filename{"bench_waveform.csv"};
+  const uint64_t transient_steps{10000};
+  const Waveform applied{Waveform::sine, 1, 1000, {}, {}};
+  auto write_waveform = [&]() {
+    ofstream waveform_file(waveform_filename.c_str());
+    Renderer out(waveform_file);
+    transient.run(applied, 1e-6, transient_steps,
+                  TransientAnalysis::trapezoidal, out);
+    return (size_t)waveform_file.tellp();
+  };
+  run("transient_run_per_step", params,
+      [&]() {
+        write_waveform();
+        return transient_steps;
+      },
+      (double)write_waveform() / transient_steps);
+  remove(waveform_filename.c_str());
+
+  MonteCarlo monte_carlo(*root, Tolerance{Tolerance::normal, 0.05});
+  // about a million component values per run, whatever the size of the tree
+  const uint64_t samples{
+      max<uint64_t>(256, 1000000 / monte_carlo.get_no_components())};
+  run("montecarlo_per_sample", params, [&]() {
+    sink = monte_carlo.run(samples, 1).modulus.get_mean();
+    return samples;
+  });
+
+  // circuit library listing
+  auto render_listing = [&]() {
+    ostringstream os;
+    {
+      Renderer out(os);
+      for (auto it : libs::circuit_lib) {
+        out << *it << "\n";
+      }
+    }
+    return os.str().size();
+  };
+  run("render_circuit_lib", params,
+      [&]() {
+        sink = render_listing();
+        return 1;
+      },
+      render_listing());
+
+  // text format
+  string text;
+  {
+    ostringstream os;
+    write_project(os, libs::component_lib, libs::circuit_lib);
+    text = os.str();
+  }
+  run("save_text", params,
+      [&]() {
+        ostringstream os;
+        write_project(os, libs::component_lib, libs::circuit_lib);
+        sink = os.tellp();
+        return 1;
+      },
+      text.size());
+
+  // binary format
+  const string filename{"bench.acb"};
+  save_binary_project(filename, libs::component_lib, libs::circuit_lib);
+  double binary_size{0};
+  {
+    ifstream file(filename, ios::binary | ios::ate);
+    binary_size = file.tellg();
+  }
+  run("save_binary", params,
+      [&]() {
+        save_binary_project(filename, libs::component_lib, libs::circuit_lib);
+        return 1;
+      },
+      binary_size);
+
+  // each load frees the previous one first
+  ostream null_stream{nullptr};
+  run("load_text", params,
+      [&]() {
+        libs::clear();
+        istringstream is(text);
+        read_project(is, null_stream, null_stream);
+        sink = libs::circuit_lib.size();
+        return 1;
+      },
+      text.size());
+  run("load_binary", params,
+      [&]() {
+        libs::clear();
+        BinaryProject project(filename);
+        for (size_t i{0}; i < project.get_no_components(); i++) {
+          libs::insert(project.get_component(i));
+        }
+        for (size_t i{0}; i < project.get_no_library_circuits(); i++) {
+          libs::insert(project.get_circuit(project.get_library_circuit(i)));
+        }
+        sink = libs::circuit_lib.size();
+        return 1;
+      },
+      binary_size);
+  remove(filename.c_str());
+}
+} // namespace
+
+//-----------------------------------------------------------------------------
+//---main function
+//-----------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+  // allocations are counted by the operator new in stats.cpp
+  stats::enable(true);
+  if (argc == 4) {
+    // one tree configuration
+    bench_tree(stoi(argv[1]), stoi(argv[2]), stod(argv[3]));
+  } else {
+    bench_complex();
+    bench_component<Resistor>("resistor_get_impedance");
+    bench_component<Capacitor>("capacitor_get_impedance");
+    bench_component<Inductor>("inductor_get_impedance");
+    // R + (C || L)
+    bench_fixed("fixed_filter",
+                SeriesT<ResistorT, ParallelT<CapacitorT, InductorT>>{
+                    {100}, {{10}, {50}}});
+    // five stage LC ladder
+    bench_fixed(
+        "fixed_ladder",
+        SeriesT<ResistorT,
+                ParallelT<CapacitorT,
+                          SeriesT<InductorT,
+                                  ParallelT<CapacitorT,
+                                            SeriesT<InductorT, ResistorT>>>>>{
+            {50}, {{10}, {{100}, {{22}, {{47}, {50}}}}}});
+    bench_tree(100, 2, 0);
+    bench_tree(1000, 3, 0);
+    bench_tree(1000, 6, 0);
+    bench_tree(10000, 4, 0);
+    bench_tree(10000, 4, 0.5);
+    bench_tree(100000, 5, 0.25);
+  }
+  libs::clear();
+  return 0;
+}
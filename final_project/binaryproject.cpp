@@ -0,0 +1,361 @@
+/* binaryproject.cpp
+ * Implementation of the memory mapped binary project format
+ *  Interface:      binaryproject.h
+ *  Author:         Dónal Murray
+ *  Date:           17/10/26
+ */
+
+#include <cstring>       // memcmp, memset, strnlen
+#include <fstream>       // file io
+#include <unordered_map> // indices of components and circuits
+#include <vector>        // vector container
+
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+
+#include "binaryproject.h" // interface
+#include "capacitor.h"     // capacitor class
+#include "circuit.h"       // circuit class
+#include "component.h"     // component base class
+#include "inductor.h"      // inductor class
+#include "label.h"         // numbered labels
+#include "library.h"       // arenas
+#include "resistor.h"      // resistor class
+#include "stats.h"         // performance counters
+
+namespace {
+const char magic[8]{'A', 'C', 'B', 'P', 'R', 'O', 'J', '\0'};
+} // namespace
+
+//-----------------------------------------------------------------------------
+//---saving
+//-----------------------------------------------------------------------------
+// save a project in the binary format
+void save_binary_project(const string &filename,
+                         const vector<Component *> &component_lib,
+                         const vector<Circuit *> &circuit_lib) {
+  stats::ScopedTimer timer{stats::save_project};
+  // string section, labels are referred to by their offset
+  string strings;
+  auto add_label = [&strings](const Label &label) -> uint32_t {
+    uint32_t offset{(uint32_t)strings.size()};
+    char buffer[Label::max_length];
+    strings += label.text(buffer);
+    strings += '\0';
+    return offset;
+  };
+
+  // component records, and the index of each component
+  unordered_map<const Component *, uint32_t> component_index;
+  vector<BinaryProject::ComponentRecord> component_records;
+  for (auto it : component_lib) {
+    BinaryProject::ComponentRecord record;
+    memset(&record, 0, sizeof(record));
+    record.value = it->get_value();
+    record.label = add_label(it->get_label_id());
+    switch (it->get_kind()) {
+    case component_kind::resistor:
+      record.kind = BinaryProject::resistor;
+      break;
+    case component_kind::capacitor:
+      record.kind = BinaryProject::capacitor;
+      break;
+    case component_kind::inductor:
+      record.kind = BinaryProject::inductor;
+      break;
+    }
+    component_index[it] = component_records.size();
+    component_records.push_back(record);
+  }
+
+  // circuit records and their child lists. Circuits are saved after their
+  // subcircuits, which connecting circuits in batch mode does not guarantee
+  // for the library. Components come before subcircuits in a child list, as
+  // they do in the circuits
+  const vector<Circuit *> order{Circuit::subcircuits_first(circuit_lib)};
+  unordered_map<const Circuit *, uint32_t> circuit_index;
+  for (size_t i{0}; i < order.size(); i++) {
+    circuit_index[order[i]] = i;
+  }
+  vector<BinaryProject::CircuitRecord> circuit_records;
+  vector<uint32_t> children;
+  for (auto it : order) {
+    BinaryProject::CircuitRecord record;
+    memset(&record, 0, sizeof(record));
+    record.frequency = it->get_frequency();
+    record.label = add_label(it->get_label_id());
+    record.first_child = children.size();
+    record.kind = dynamic_cast<Parallel *>(it) != nullptr
+                      ? BinaryProject::parallel
+                      : BinaryProject::series;
+    for (auto comp : it->get_components()) {
+      children.push_back(component_index.at(comp));
+    }
+    for (auto sub : it->get_subcircuits()) {
+      children.push_back(circuit_index.at(sub) | BinaryProject::circuit_bit);
+    }
+    record.child_count = children.size() - record.first_child;
+    circuit_records.push_back(record);
+  }
+  // record of each circuit in the library, in library order
+  vector<uint32_t> library_order;
+  library_order.reserve(circuit_lib.size());
+  for (auto it : circuit_lib) {
+    library_order.push_back(circuit_index.at(it));
+  }
+
+  // header and section directory, followed by the sections in order
+  const uint32_t section_count{5};
+  BinaryProject::Header header;
+  memcpy(header.magic, magic, sizeof(magic));
+  header.version = BinaryProject::version;
+  header.section_count = section_count;
+  BinaryProject::Section sections[section_count]{
+      {BinaryProject::component_section, 0, 0,
+       component_records.size() * sizeof(BinaryProject::ComponentRecord)},
+      {BinaryProject::circuit_section, 0, 0,
+       circuit_records.size() * sizeof(BinaryProject::CircuitRecord)},
+      {BinaryProject::child_section, 0, 0, children.size() * sizeof(uint32_t)},
+      {BinaryProject::string_section, 0, 0, strings.size()},
+      {BinaryProject::order_section, 0, 0,
+       library_order.size() * sizeof(uint32_t)}};
+  uint64_t offset{sizeof(header) + sizeof(sections)};
+  for (auto &it : sections) {
+    // keep every section 8 byte aligned so the records can be used in place
+    offset = (offset + 7) & ~(uint64_t)7;
+    it.offset = offset;
+    offset += it.size;
+  }
+  const void *contents[section_count]{
+      component_records.data(), circuit_records.data(), children.data(),
+      strings.data(), library_order.data()};
+
+  ofstream save_file(filename.c_str(), ios::binary);
+  if (!save_file.good()) {
+    throw(3);
+  }
+  save_file.write((const char *)&header, sizeof(header));
+  save_file.write((const char *)sections, sizeof(sections));
+  uint64_t position{sizeof(header) + sizeof(sections)};
+  const char padding[8]{};
+  for (uint32_t i{0}; i < section_count; i++) {
+    save_file.write(padding, sections[i].offset - position);
+    save_file.write((const char *)contents[i], sections[i].size);
+    position = sections[i].offset + sections[i].size;
+  }
+  if (!save_file.good()) {
+    throw(3);
+  }
+  stats::add(stats::bytes_saved, position);
+}
+
+//-----------------------------------------------------------------------------
+//---loading
+//-----------------------------------------------------------------------------
+// map the file and find the sections. Nothing is created here, and only the
+// library order is checked
+BinaryProject::BinaryProject(const string &filename)
+    : data{nullptr}, size{0}, component_records{nullptr},
+      circuit_records{nullptr}, children{nullptr}, strings{nullptr},
+      order{nullptr}, no_components{0}, no_circuits{0}, no_children{0},
+      strings_size{0}, no_ordered{0} {
+  int fd{open(filename.c_str(), O_RDONLY)};
+  if (fd < 0) {
+    throw(3);
+  }
+  struct stat file_stat;
+  if ((fstat(fd, &file_stat) != 0) || (file_stat.st_size < 1)) {
+    close(fd);
+    throw(4);
+  }
+  size = file_stat.st_size;
+  void *mapped{mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+  // the mapping stays valid after the file is closed
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    throw(3);
+  }
+  data = (char *)mapped;
+  stats::add(stats::bytes_loaded, size);
+
+  try {
+    // check the header
+    if (size < sizeof(Header)) {
+      throw(4);
+    }
+    const Header *header{(const Header *)data};
+    if ((memcmp(header->magic, magic, sizeof(magic)) != 0) ||
+        (header->version != version) ||
+        (header->section_count > (size - sizeof(Header)) / sizeof(Section))) {
+      throw(4);
+    }
+    // read the section directory
+    const Section *sections{(const Section *)(data + sizeof(Header))};
+    for (uint32_t i{0}; i < header->section_count; i++) {
+      const Section &section{sections[i]};
+      if ((section.offset % 8 != 0) || (section.offset > size) ||
+          (section.size > size - section.offset)) {
+        throw(4);
+      }
+      const char *start{data + section.offset};
+      switch (section.type) {
+      case component_section:
+        component_records = (const ComponentRecord *)start;
+        no_components = section.size / sizeof(ComponentRecord);
+        break;
+      case circuit_section:
+        circuit_records = (const CircuitRecord *)start;
+        no_circuits = section.size / sizeof(CircuitRecord);
+        break;
+      case child_section:
+        children = (const uint32_t *)start;
+        no_children = section.size / sizeof(uint32_t);
+        break;
+      case string_section:
+        strings = start;
+        strings_size = section.size;
+        break;
+      case order_section:
+        order = (const uint32_t *)start;
+        no_ordered = section.size / sizeof(uint32_t);
+        break;
+      default:
+        // unknown sections from later versions are skipped
+        break;
+      }
+    }
+    if (order != nullptr) {
+      // each circuit can only be in the library once
+      vector<bool> ordered(no_circuits, false);
+      for (size_t i{0}; i < no_ordered; i++) {
+        if ((order[i] >= no_circuits) || ordered[order[i]]) {
+          throw(4);
+        }
+        ordered[order[i]] = true;
+      }
+    }
+  } catch (int &) {
+    munmap(data, size);
+    throw;
+  }
+  components.assign(no_components, nullptr);
+  circuits.assign(no_circuits, nullptr);
+}
+
+// unmap the file
+BinaryProject::~BinaryProject() { munmap(data, size); }
+
+// number of components and circuits in the file
+size_t BinaryProject::get_no_components() const { return no_components; }
+size_t BinaryProject::get_no_circuits() const { return no_circuits; }
+
+// circuits in the circuit library
+size_t BinaryProject::get_no_library_circuits() const {
+  return (order != nullptr) ? no_ordered : no_circuits;
+}
+size_t BinaryProject::get_library_circuit(const size_t &i) const {
+  if (i >= get_no_library_circuits()) {
+    throw(4);
+  }
+  return (order != nullptr) ? order[i] : i;
+}
+
+// return a label from the string section
+string BinaryProject::get_string(const uint32_t &offset) const {
+  if (offset >= strings_size) {
+    throw(4);
+  }
+  return string(strings + offset, strnlen(strings + offset,
+                                          strings_size - offset));
+}
+
+// label of a circuit without creating it
+string BinaryProject::get_circuit_label(const size_t &i) const {
+  if (i >= no_circuits) {
+    throw(4);
+  }
+  return get_string(circuit_records[i].label);
+}
+
+// create a component the first time it is asked for
+Component *BinaryProject::get_component(const size_t &i) {
+  if (i >= no_components) {
+    throw(4);
+  }
+  if (components[i] == nullptr) {
+    const ComponentRecord &record{component_records[i]};
+    // read the label first so that a bad record creates nothing
+    const string label{get_string(record.label)};
+    Component *comp;
+    switch (record.kind) {
+    case resistor:
+      comp = libs::make<Resistor>(record.value);
+      break;
+    case capacitor:
+      comp = libs::make<Capacitor>(record.value);
+      break;
+    case inductor:
+      comp = libs::make<Inductor>(record.value);
+      break;
+    default:
+      throw(4);
+    }
+    comp->set_label(label);
+    components[i] = comp;
+  }
+  return components[i];
+}
+
+// create a circuit the first time it is asked for, creating its components
+// and subcircuits first. Everything in the record is checked before anything
+// is created, so a bad record leaves nothing half built
+Circuit *BinaryProject::get_circuit(const size_t &i) {
+  if (i >= no_circuits) {
+    throw(4);
+  }
+  if (circuits[i] == nullptr) {
+    const CircuitRecord &record{circuit_records[i]};
+    if ((record.first_child > no_children) ||
+        (record.child_count > no_children - record.first_child) ||
+        ((record.kind != series) && (record.kind != parallel))) {
+      throw(4);
+    }
+    const string label{get_string(record.label)};
+    if (!Circuit::is_valid_label(label, record.kind == parallel)) {
+      // the label does not match the kind of circuit
+      throw(4);
+    }
+    const uint32_t *first{children + record.first_child};
+    const uint32_t *last{first + record.child_count};
+    for (const uint32_t *child{first}; child != last; child++) {
+      if (*child & circuit_bit) {
+        // subcircuits are saved before the circuits which contain them, so
+        // this also rules out a circuit containing itself
+        if ((*child & ~circuit_bit) >= i) {
+          throw(4);
+        }
+        get_circuit(*child & ~circuit_bit);
+      } else {
+        get_component(*child);
+      }
+    }
+    Circuit *circ;
+    if (record.kind == parallel) {
+      circ = libs::make<Parallel>(record.frequency);
+    } else {
+      circ = libs::make<Series>(record.frequency);
+    }
+    circ->set_label(label);
+    for (const uint32_t *child{first}; child != last; child++) {
+      if (*child & circuit_bit) {
+        circ->add_subcircuit(circuits[*child & ~circuit_bit]);
+      } else {
+        circ->add_component(components[*child]);
+      }
+    }
+    circuits[i] = circ;
+  }
+  return circuits[i];
+}
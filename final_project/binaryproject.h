@@ -0,0 +1,125 @@
+/* binaryproject.h
+ * Interface for the binary project format. A binary project is a header, a
+ * directory of sections and the sections themselves:
+ *    components  fixed width component records
+ *    circuits    fixed width circuit records
+ *    children    child index lists of the circuits
+ *    strings     nul terminated labels
+ *    order       indices of the circuits in the library, in library order
+ * Circuits are saved after their subcircuits, and the order section puts them
+ * back in library order when they are loaded. The file is memory mapped when
+ * it is opened, and each component or circuit is created from its record the
+ * first time it is asked for. Loading a project into the libraries asks for
+ * every one of them, so the format saves reading and parsing the file but
+ * every component and circuit is still created when it is loaded
+ *  Implementation:  binaryproject.cpp
+ *  Author:          Dónal Murray
+ *  Date:            17/10/26
+ */
+
+#ifndef BINARYPROJECT_H
+#define BINARYPROJECT_H
+
+#include <cstddef> // size_t
+#include <cstdint> // fixed width integers
+#include <string>  // filenames and labels
+#include <vector>  // vector container
+
+#include "circuit.h"   // circuit class
+#include "component.h" // component base class
+
+// save a project in the binary format (filename, components, circuits)
+void save_binary_project(const string &, const vector<Component *> &,
+                         const vector<Circuit *> &);
+
+class BinaryProject {
+public:
+  // on-disk layout, version 1
+  static const uint32_t version{1};
+  enum section_type : uint32_t {
+    component_section = 1,
+    circuit_section,
+    child_section,
+    string_section,
+    order_section
+  };
+  enum record_kind : uint8_t { resistor, capacitor, inductor, series, parallel };
+  // children with this bit set refer to circuits rather than components
+  static const uint32_t circuit_bit{0x80000000u};
+
+  struct Header {
+    char magic[8];          // "ACBPROJ" and a nul
+    uint32_t version;       // format version
+    uint32_t section_count; // number of entries in the directory
+  };
+  struct Section {
+    uint32_t type; // section_type
+    uint32_t reserved;
+    uint64_t offset; // from the start of the file
+    uint64_t size;   // in bytes
+  };
+  struct ComponentRecord {
+    double value;   // resistance/capacitance/inductance
+    uint32_t label; // offset into the string section
+    uint8_t kind;   // record_kind
+    uint8_t reserved[3];
+  };
+  struct CircuitRecord {
+    double frequency;     // frequency of the circuit
+    uint32_t label;       // offset into the string section
+    uint32_t first_child; // index into the child section
+    uint32_t child_count; // number of components and subcircuits
+    uint8_t kind;         // record_kind
+    uint8_t reserved[3];
+  };
+
+private:
+  char *data;  // mapped file
+  size_t size; // size of mapped file
+  const ComponentRecord *component_records;
+  const CircuitRecord *circuit_records;
+  const uint32_t *children;
+  const char *strings;
+  const uint32_t *order; // nullptr if the file has no order section
+  size_t no_components;
+  size_t no_circuits;
+  size_t no_children;
+  size_t strings_size;
+  size_t no_ordered;
+
+  // components and circuits created so far, nullptr if not yet created
+  vector<Component *> components;
+  vector<Circuit *> circuits;
+
+  // return a label from the string section (offset)
+  string get_string(const uint32_t &) const;
+
+public:
+  // map a binary project file and read its section directory (filename)
+  BinaryProject(const string &);
+  // the mapping cannot be shared
+  BinaryProject(const BinaryProject &) = delete;
+  BinaryProject &operator=(const BinaryProject &) = delete;
+  // destructor - unmaps the file. Components and circuits which have been
+  // created belong to the arenas in libs
+  ~BinaryProject();
+
+  // number of components and circuits in the file
+  size_t get_no_components() const;
+  size_t get_no_circuits() const;
+  // number of circuits in the circuit library, and the index of the circuit
+  // at a position of it (position). Files without an order section list every
+  // circuit in the order it was saved
+  size_t get_no_library_circuits() const;
+  size_t get_library_circuit(const size_t &) const;
+  // label of a circuit without creating it (index)
+  string get_circuit_label(const size_t &) const;
+
+  // create (on the first call) and return a component (index)
+  Component *get_component(const size_t &);
+  // create (on the first call) and return a circuit after all of its
+  // components and subcircuits (index)
+  Circuit *get_circuit(const size_t &);
+};
+
+#endif
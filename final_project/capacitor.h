@@ -9,21 +9,19 @@
 #ifndef CAPACITOR_H
 #define CAPACITOR_H
 
+#include <atomic>  // counter
+#include <cstdint> // fixed width integers
+
 #include "complex.h"
 #include "component.h"
 
 class Capacitor : public Component {
 private:
-  static int capacitor_count;
+  static atomic<uint32_t> capacitor_count; // number of the last capacitor
 
 public:
   // parametrised constructor (capacitance in micro farads)
   Capacitor(const double &);
-  // destructor
-  ~Capacitor();
-
-  // calculate impedence of component
-  Complex get_impedance(const double &) const;
 };
 
 #endif
@@ -5,9 +5,11 @@
  *  Date:           29/03/17
  */
 
-#include <iostream> // std io
-#include <sstream>  // stringstream
-#include <vector>   // vector type
+#include <iostream>      // std io
+#include <string>        // string labels
+#include <string_view>   // labels to check
+#include <unordered_set> // circuits already ordered or searched
+#include <vector>        // vector type
 
 #include "circuit.h" // class interface
 
@@ -15,32 +17,42 @@
 #include "complex.h"   // complex class
 #include "component.h" // component base class
 #include "inductor.h"  // inductor class
+#include "library.h"   // library registry
+#include "renderer.h"  // buffered output
 #include "resistor.h"  // resistor class
+#include "stats.h"     // performance counters
+
+namespace {
+// add a circuit to the order after everything it contains (circuit, circuits
+// already added, order)
+void add_in_order(Circuit *circ, unordered_set<const Circuit *> &added,
+                  vector<Circuit *> &order) {
+  if (!added.insert(circ).second) {
+    return;
+  }
+  for (auto sub : circ->get_subcircuits()) {
+    add_in_order(sub, added, order);
+  }
+  order.push_back(circ);
+}
+} // namespace
 
 //-----------------------------------------------------------------------------
 //---base class
 //-----------------------------------------------------------------------------
 
-int Circuit::circuit_count{0}; // initialise static data member
+atomic<uint32_t> Circuit::circuit_count{0}; // initialise static data member
 
 // default constructor
-Circuit::Circuit() : frequency{0} {
-  circuit_count++;
-  // add circuit number to label
-  stringstream comp_label;
-  comp_label << label << circuit_count;
-  label = comp_label.str();
-}
+Circuit::Circuit()
+    : frequency{0}, label{0, ++circuit_count}, cache_frequency{0},
+      cache_valid{false} {}
 
-// parametrised constructor (frequency)
-Circuit::Circuit(const double &freq, const string &lab)
-    : frequency{freq}, label(lab) {
-  circuit_count++;
-  // add circuit number to label
-  stringstream comp_label;
-  comp_label << label << circuit_count;
-  label = comp_label.str();
-}
+// parametrised constructor (frequency, letter of the label), labelled with the
+// letter and the circuit number
+Circuit::Circuit(const double &freq, const char &letter)
+    : frequency{freq}, label{letter, ++circuit_count}, cache_frequency{0},
+      cache_valid{false} {}
 
 // destructor
 Circuit::~Circuit() {
@@ -58,7 +70,10 @@ double Circuit::get_frequency() const { return frequency; }
 // change the frequency
 void Circuit::set_frequency(const double &freq) {
   // change frequency of circuit
-  frequency = freq;
+  if (freq != frequency) {
+    frequency = freq;
+    invalidate();
+  }
   // change frequency of all subcircuits
   for (auto it = subcircuits.begin(); it != subcircuits.end(); it++) {
     (*it)->set_frequency(freq);
@@ -66,19 +81,87 @@ void Circuit::set_frequency(const double &freq) {
 }
 
 // return label
-string Circuit::get_label() const { return label; }
+string Circuit::get_label() const { return label.str(); }
+
+// rename circuit, keeping the library registry up to date
+void Circuit::set_label(const string &lab) {
+  if (!is_valid_label(lab, dynamic_cast<const Parallel *>(this) != nullptr)) {
+    // the label would be read back as the other kind of circuit
+    throw(1);
+  }
+  set_label(Label{lab});
+}
 
-// rename circuit
-void Circuit::set_label(const string &lab) { label = lab; }
+void Circuit::set_label(const Label &lab) {
+  const Label old_label{label};
+  label = lab;
+  libs::relabel(this, old_label);
+}
+
+// whether a label starts with S for a series circuit or P for a parallel one
+bool Circuit::is_valid_label(const string_view &lab, const bool &parallel) {
+  return !lab.empty() && (lab[0] == (parallel ? 'P' : 'S'));
+}
 
 // add component (component)
 void Circuit::add_component(Component *new_comp) {
   components.push_back(new_comp);
+  // let the component know so that changing its value invalidates this
+  new_comp->add_parent(this);
+  invalidate();
 }
 
 // add subcircuit (subcircuit)
 void Circuit::add_subcircuit(Circuit *new_circ) {
   subcircuits.push_back(new_circ);
+  new_circ->parents.push_back(this);
+  invalidate();
+}
+
+// whether a circuit is this one or is below it. Shared subcircuits are only
+// searched once
+bool Circuit::contains(const Circuit *circ) const {
+  vector<const Circuit *> to_search{this};
+  unordered_set<const Circuit *> searched{this};
+  while (!to_search.empty()) {
+    const Circuit *next{to_search.back()};
+    to_search.pop_back();
+    if (next == circ) {
+      return true;
+    }
+    for (auto it : next->subcircuits) {
+      if (searched.insert(it).second) {
+        to_search.push_back(it);
+      }
+    }
+  }
+  return false;
+}
+
+// discard the cached impedance. A circuit is only ever valid if all of its
+// subcircuits are, so if this circuit is already invalid then so is every
+// circuit above it and there is no need to go any further
+void Circuit::invalidate() {
+  if (cache_valid) {
+    cache_valid = false;
+    for (auto it : parents) {
+      it->invalidate();
+    }
+  }
+}
+
+// return the impedance of the circuit, only recalculating it if the circuit
+// or something below it has changed since the last time
+Complex Circuit::get_impedance() const {
+  if (!cache_valid || (cache_frequency != frequency)) {
+    stats::add(stats::cache_misses);
+    impedance_cache = calculate_impedance();
+    cache_frequency = frequency;
+    cache_valid = true;
+  } else {
+    stats::add(stats::cache_hits);
+  }
+  return impedance_cache;
 }
 
 // calculate the magnitude of the impedance of the circuit
@@ -95,74 +178,113 @@ double Circuit::get_phase_difference() const {
   return (get_impedance()).argument();
 }
 
+// access the components of the circuit
+const vector<Component *> &Circuit::get_components() const {
+  return components;
+}
+
+// access the subcircuits of the circuit
+const vector<Circuit *> &Circuit::get_subcircuits() const {
+  return subcircuits;
+}
+
+// circuits with every subcircuit before the circuits containing it
+vector<Circuit *> Circuit::subcircuits_first(const vector<Circuit *> &circs) {
+  vector<Circuit *> order;
+  order.reserve(circs.size());
+  unordered_set<const Circuit *> added;
+  for (auto it : circs) {
+    add_in_order(it, added, order);
+  }
+  return order;
+}
+
+// print circuit graphically to the console
+void Circuit::print_circuit() {
+  Renderer out(cout);
+  print_circuit(out);
+}
+
 //-----------------------------------------------------------------------------
 //---friend functions
 //-----------------------------------------------------------------------------
 // overload ostream operator for circuits
 ostream &operator<<(ostream &os, const Circuit &circ) {
-  os << "  " << circ.label << "  " << circ.frequency << "Hz  "
-     << circ.get_mag_impedance() << "   ( ";
+  Renderer out(os);
+  out << circ;
+  return os;
+}
+
+// render a circuit as a line of the circuit library
+Renderer &operator<<(Renderer &out, const Circuit &circ) {
+  out << "  " << circ.label << "  " << circ.frequency << "Hz  "
+      << circ.get_mag_impedance() << "   ( ";
   for (auto it : circ.components) {
-    os << it->get_label() << " ";
+    out << it->get_label_id() << " ";
   }
   for (auto it : circ.subcircuits) {
-    os << it->label << " ";
+    out << it->label << " ";
   }
-  os << ")";
-  return os;
+  out << ")";
+  return out;
 }
 
 //-----------------------------------------------------------------------------
 //---Series derived class
 //-----------------------------------------------------------------------------
 // constructor
-Series::Series(const double &freq) : Circuit(freq, "S") {}
+Series::Series(const double &freq) : Circuit(freq, 'S') {}
 // print series circuit
-void Series::print_circuit() {
+void Series::print_circuit(Renderer &out) {
   // series circuit, just print in line
-  cout << "\nPrinting circuit " << label << " which has a frequency "
-       << frequency << "Hz\ntotal impedance Z=" << get_impedance()
-       << "\nmagnitude of impedence |Z|=" << get_mag_impedance() << "\u03A9"
-       << "\nphase difference " << get_phase_difference() << "\n\n"
-       << "+--(~)--+\n";
+  out << "\nPrinting circuit " << label << " which has a frequency "
+      << frequency << "Hz\ntotal impedance Z=" << get_impedance()
+      << "\nmagnitude of impedence |Z|=" << get_mag_impedance() << "\u03A9"
+      << "\nphase difference " << get_phase_difference() << "\n\n"
+      << "+--(~)--+\n";
   for (auto it : subcircuits) {
     // the component is a subcircuit
-    cout << "|       |\n"
-         << "|     .-+-.\n"
-         << "|     |" << it->get_label() << " |\n"
-         << "|     '-+-' |Z|=" << it->get_mag_impedance() << "\u03A9\n";
+    out << "|       |\n"
+        << "|     .-+-.\n"
+        << "|     |" << it->get_label_id() << " |\n"
+        << "|     '-+-' |Z|=" << it->get_mag_impedance() << "\u03A9\n";
   }
   for (auto it : components) {
-    if (!(dynamic_cast<Resistor *>(it) == nullptr)) {
+    switch (it->get_kind()) {
+    case component_kind::resistor:
       // the component is a resistor
-      cout << "|       |\n"
-           << "|      .+.\n"
-           << "|      | | " << it->get_label() << endl
-           << "|      '+' |Z|=" << it->get_mag_impedance(frequency)
-           << "\u03A9\n";
-    } else if (!(dynamic_cast<Capacitor *>(it) == nullptr)) {
-      // the component is a resistor
-      cout << "|       |\n"
-           << "|       |\n"
-           << "|      === " << it->get_label() << endl
-           << "|       |  |Z|=" << it->get_mag_impedance(frequency)
-           << "\u03A9\n";
-    } else if (!(dynamic_cast<Inductor *>(it) == nullptr)) {
+      out << "|       |\n"
+          << "|      .+.\n"
+          << "|      | | " << it->get_label_id() << "\n"
+          << "|      '+' |Z|=" << it->get_mag_impedance(frequency)
+          << "\u03A9\n";
+      break;
+    case component_kind::capacitor:
+      // the component is a capacitor
+      out << "|       |\n"
+          << "|       |\n"
+          << "|      === " << it->get_label_id() << "\n"
+          << "|       |  |Z|=" << it->get_mag_impedance(frequency)
+          << "\u03A9\n";
+      break;
+    case component_kind::inductor:
       // the component is an inductor
-      cout << "|       |\n"
-           << "|       $\n"
-           << "|       $  " << it->get_label() << endl
-           << "|       $  |Z|=" << it->get_mag_impedance(frequency)
-           << "\u03A9\n";
+      out << "|       |\n"
+          << "|       $\n"
+          << "|       $  " << it->get_label_id() << "\n"
+          << "|       $  |Z|=" << it->get_mag_impedance(frequency)
+          << "\u03A9\n";
+      break;
     }
   }
   // draw end line
-  cout << "|       |\n"
-          "+-------+\n\n\n";
+  out << "|       |\n"
+         "+-------+\n\n\n";
 }
 
 // calculate the impedence of the whole circuit
-Complex Series::get_impedance() const {
+Complex Series::calculate_impedance() const {
+  stats::add(stats::series_evaluations);
   Complex temp{0, 0};
   for (auto it = components.begin(); it != components.end(); it++) {
     temp = temp + (*it)->get_impedance(frequency);
@@ -177,53 +299,58 @@ Complex Series::get_impedance() const {
 //---Parallel derived class
 //-----------------------------------------------------------------------------
 // constructor;
-Parallel::Parallel(const double &freq) : Circuit(freq, "P") {}
+Parallel::Parallel(const double &freq) : Circuit(freq, 'P') {}
 // print parallel circuit
-void Parallel::print_circuit() {
+void Parallel::print_circuit(Renderer &out) {
   // parallel circuit
-  cout << "\nPrinting circuit " << label << " which has a frequency "
-       << frequency << "Hz\ntotal impedance Z=" << get_impedance()
-       << "\nmagnitude of impedence |Z|=" << get_mag_impedance() << "\u03A9"
-       << "\nphase difference " << get_phase_difference() << "\n\n"
-       << "+--(~)---+\n";
+  out << "\nPrinting circuit " << label << " which has a frequency "
+      << frequency << "Hz\ntotal impedance Z=" << get_impedance()
+      << "\nmagnitude of impedence |Z|=" << get_mag_impedance() << "\u03A9"
+      << "\nphase difference " << get_phase_difference() << "\n\n"
+      << "+--(~)---+\n";
   // draw placeholders for any subcircuits
   for (auto it : subcircuits) {
     // print subcircuits
-    cout << "|        |\n"
-         << "| +----+ |\n"
-         << "| | " << it->get_label() << " | | |Z|=" << it->get_mag_impedance()
-         << "\u03A9\n"
-         << "+-+----+-+\n";
+    out << "|        |\n"
+        << "| +----+ |\n"
+        << "| | " << it->get_label_id()
+        << " | | |Z|=" << it->get_mag_impedance() << "\u03A9\n"
+        << "+-+----+-+\n";
   }
 
   for (auto it : components) {
-    if (!(dynamic_cast<Resistor *>(it) == nullptr)) {
-      // the component is a resistor
-      cout << "|        |\n"
-           << "|        |\n"
-           << "|  ____  | " << it->get_label() << endl
-           << "+-+____+-+ |Z|=" << it->get_mag_impedance(frequency)
-           << "\u03A9\n";
-    } else if (!(dynamic_cast<Capacitor *>(it) == nullptr)) {
+    switch (it->get_kind()) {
+    case component_kind::resistor:
       // the component is a resistor
-      cout << "|        |\n"
-           << "|        |\n"
-           << "|        | " << it->get_label() << endl
-           << "+---||---+ |Z|=" << it->get_mag_impedance(frequency)
-           << "\u03A9\n";
-    } else if (!(dynamic_cast<Inductor *>(it) == nullptr)) {
+      out << "|        |\n"
+          << "|        |\n"
+          << "|  ____  | " << it->get_label_id() << "\n"
+          << "+-+____+-+ |Z|=" << it->get_mag_impedance(frequency)
+          << "\u03A9\n";
+      break;
+    case component_kind::capacitor:
+      // the component is a capacitor
+      out << "|        |\n"
+          << "|        |\n"
+          << "|        | " << it->get_label_id() << "\n"
+          << "+---||---+ |Z|=" << it->get_mag_impedance(frequency)
+          << "\u03A9\n";
+      break;
+    case component_kind::inductor:
       // the component is an inductor
-      cout << "|        |\n"
-           << "|        |\n"
-           << "|        | " << it->get_label() << endl
-           << "+-+/\\/\\+-+ |Z|=" << it->get_mag_impedance(frequency)
-           << "\u03A9\n";
+      out << "|        |\n"
+          << "|        |\n"
+          << "|        | " << it->get_label_id() << "\n"
+          << "+-+/\\/\\+-+ |Z|=" << it->get_mag_impedance(frequency)
+          << "\u03A9\n";
+      break;
     }
   }
 }
 
 // calculate the impedence of the whole circuit
-Complex Parallel::get_impedance() const {
+Complex Parallel::calculate_impedance() const {
+  stats::add(stats::parallel_evaluations);
   Complex temp{0, 0};
   Complex one{1, 0};
   for (auto it = components.begin(); it != components.end(); it++) {
@@ -8,30 +8,45 @@
 #ifndef CIRCUIT_H
 #define CIRCUIT_H
 
+#include <atomic>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "capacitor.h" // capacitor class
 #include "component.h" // component base class
 #include "inductor.h"  // inductor class
+#include "label.h"     // numbered labels
+#include "renderer.h"  // buffered output
 #include "resistor.h"  // resistor class
 
 class Circuit {
   friend ostream &operator<<(ostream &, const Circuit &);
+  friend Renderer &operator<<(Renderer &, const Circuit &);
 
 protected:
   double frequency;               // frequency of AC circuit
-  double impedence;               // impedence of whole circuit
-  string label;                   // circuit label
+  Label label;                    // label, formatted when it is printed
   vector<Component *> components; // polymorphic vector to add components
   vector<Circuit *> subcircuits;  // for nesting series/parallel circuits
-  static int circuit_count;       // to make sure circuit IDs are unique
+  vector<Circuit *> parents;      // circuits which contain this one
+  // number of the last circuit, to make sure circuit IDs are unique
+  static atomic<uint32_t> circuit_count;
+
+  // cached impedance of the whole circuit, only valid at cache_frequency
+  mutable Complex impedance_cache;
+  mutable double cache_frequency;
+  mutable bool cache_valid;
+
+  // calculate the impedance of the whole circuit from its contents
+  virtual Complex calculate_impedance() const = 0;
 
 public:
   // default constructor
   Circuit();
-  // parametrised constructor (frequency, label)
-  Circuit(const double &, const string &);
+  // parametrised constructor (frequency, letter of the label)
+  Circuit(const double &, const char &);
   // destructor
   ~Circuit();
 
@@ -44,44 +59,71 @@ public:
   void add_component(Component *);
   // add subcircuit (subcircuit)
   void add_subcircuit(Circuit *);
+  // whether a circuit is this one or is below it at any depth, so that adding
+  // this circuit to it would make a loop (circuit)
+  bool contains(const Circuit *) const;
   // get label
   string get_label() const;
-  // rename circuit
+  // get label without formatting it, e.g. to compare or render it
+  const Label &get_label_id() const { return label; }
+  // rename circuit. Text labels must start with the letter of the kind of
+  // circuit, as that is how the text format tells them apart
   void set_label(const string &);
+  void set_label(const Label &);
+  // whether a label can be given to a series or parallel circuit (label,
+  // parallel)
+  static bool is_valid_label(const string_view &, const bool &);
   // get total number of components and subcircuits
   int get_no_components() const;
+  // discard the cached impedance of this circuit and every circuit above it
+  void invalidate();
+  // calculate the impedence of the whole circuit (cached)
+  Complex get_impedance() const;
   // calculate the magnitude of the impedance of the circuit
   double get_mag_impedance() const;
   // calculate the total phase difference
   double get_phase_difference() const;
+  // access the components and subcircuits (e.g. to compile a sweep)
+  const vector<Component *> &get_components() const;
+  const vector<Circuit *> &get_subcircuits() const;
+  // circuits in the same order except that every subcircuit comes before the
+  // circuits containing it, e.g. to save them (circuits)
+  static vector<Circuit *> subcircuits_first(const vector<Circuit *> &);
+
+  // print circuit graphically to the console
+  void print_circuit();
 
   // subclass specific functions
-  // calculate the impedence of the whole circuit
-  virtual Complex get_impedance() const = 0;
-  // print circuit graphically
-  virtual void print_circuit() = 0;
+  // draw circuit graphically (renderer)
+  virtual void print_circuit(Renderer &) = 0;
 };
 
 // subclass series inherits from circuit
 class Series : public Circuit {
+protected:
+  // calculate the impedence of the whole circuit
+  Complex calculate_impedance() const;
+
 public:
   // constructor
   Series(const double &);
-  // calculate the impedence of the whole circuit
-  Complex get_impedance() const;
-  // print circuits graphically
-  void print_circuit();
+  // draw circuits graphically (renderer)
+  using Circuit::print_circuit;
+  void print_circuit(Renderer &);
 };
 
 // subclass series inherits from circuit
 class Parallel : public Circuit {
+protected:
+  // calculate the impedence of the whole circuit
+  Complex calculate_impedance() const;
+
 public:
   // constructor
   Parallel(const double &);
-  // calculate the impedence of the whole circuit
-  Complex get_impedance() const;
-  // print circuits graphically
-  void print_circuit();
+  // draw circuits graphically (renderer)
+  using Circuit::print_circuit;
+  void print_circuit(Renderer &);
 };
 
 #endif
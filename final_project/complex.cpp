@@ -1,85 +1,15 @@
 /* complex.cpp
- * Implementation of Complex class to store and manipulate complex numbers
+ * Implementation of the stream operators of the Complex class, the rest of the
+ * class is defined in the header
  *  Interface:      complex.h
  *  Author:         Dónal Murray
  *  Date:           29/03/17
  */
 
-#include <cmath>    // sqrt, pow, atan2
-#include <iomanip>  // set precision
 #include <iostream> // std io
 
 #include "complex.h" // class interface
 
-// default constructor
-Complex::Complex() : real{0}, imaginary{0} {}
-
-// parametrised constructors
-Complex::Complex(const double &re, const double &im)
-    : real{re}, imaginary{im} {}
-
-// destructor
-Complex::~Complex() {}
-
-// modifiers
-void Complex::set_real(const double &re) { real = re; }
-void Complex::set_imaginary(const double &im) { imaginary = im; }
-
-// accessors
-double Complex::get_real() const { return real; }
-double Complex::get_imaginary() const { return imaginary; }
-
-// member functions to return modulus and argument
-double Complex::modulus() const {
-  return sqrt(pow(real, 2) + pow(imaginary, 2));
-}
-double Complex::argument() const { return pow(atan2(imaginary, real), 2); }
-
-// function to calculate the complex conjugate of a complex number
-Complex Complex::conjugate() const // return complex conjugate
-{
-  Complex temp{real, imaginary}; // clone input complex number
-  temp.set_real(real);
-  if (imaginary != 0) {
-    // imaginary is not zero, invert the sign
-    temp.set_imaginary(-1 * imaginary);
-  }
-  return temp;
-}
-
-// define the addition of two complex numbers
-Complex Complex::operator+(const Complex &z2) const // return sum
-{
-  Complex temp{real + z2.real, imaginary + z2.imaginary};
-  return temp;
-}
-
-// define the subtraction of two complex numbers
-Complex Complex::operator-(const Complex &z2) const // return difference
-{
-  Complex temp{real - z2.real, imaginary - z2.imaginary};
-  return temp;
-}
-
-// define the product of two complex numbers
-Complex Complex::operator*(const Complex &z2) const // return product
-{
-  // x*y = (Re{x}*Re{y} - Im{x}*Im{y}) + i(Re{x}*Im{y}+Im{x}*Im{y})
-  Complex temp{real * z2.real - imaginary * z2.imaginary,
-               real * z2.imaginary + imaginary * z2.real};
-  return temp;
-}
-
-// define the quotient of two complex numbers
-Complex Complex::operator/(const Complex &z2) const {
-  Complex result(z2.get_real(), z2.get_imaginary());
-  result.real = ((real * z2.real) + (imaginary * z2.imaginary)) /
-                ((pow(z2.real, 2)) + (pow(z2.imaginary, 2)));
-  result.imaginary = ((imaginary * z2.real) - (real * z2.imaginary)) /
-                     ((pow(z2.real, 2)) + (pow(z2.imaginary, 2)));
-  return result;
-}
-
 // define how complex numbers are inserted into an ostream
 ostream &operator<<(ostream &os, const Complex &z) // define ostream behaviour
 {
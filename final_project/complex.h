@@ -1,6 +1,9 @@
 /* complex.h
- * Interface for Complex class to store and manipulate complex numbers
- *  Implementation: complex.cpp
+ * Interface and implementation of Complex class to store and manipulate
+ * complex numbers. Everything apart from the stream operators is defined here
+ * so that the arithmetic can be inlined, and is constexpr where the standard
+ * library allows it
+ *  Implementation: complex.cpp (stream operators)
  *  Author:         Dónal Murray
  *  Date:           29/03/17
  */
@@ -8,6 +11,7 @@
 #ifndef COMPLEX_H
 #define COMPLEX_H
 
+#include <cmath>    // sqrt, atan2
 #include <iostream> // i/ostream types
 
 using namespace std;
@@ -25,30 +29,52 @@ private:
 
 public:
   // default constructor
-  Complex();
+  constexpr Complex() : real{0}, imaginary{0} {}
   // parametrised constructors
-  Complex(const double &, const double &);
-  // destructor
-  ~Complex();
+  constexpr Complex(const double &re, const double &im)
+      : real{re}, imaginary{im} {}
 
   // modifiers
-  void set_real(const double &);
-  void set_imaginary(const double &);
+  constexpr void set_real(const double &re) { real = re; }
+  constexpr void set_imaginary(const double &im) { imaginary = im; }
 
   // accessors
-  double get_real() const;
-  double get_imaginary() const;
+  constexpr double get_real() const { return real; }
+  constexpr double get_imaginary() const { return imaginary; }
 
   // member functions
-  double modulus() const;    // return modulus
-  double argument() const;   // return argument
-  Complex conjugate() const; // return conjugate
+  // return modulus
+  double modulus() const { return sqrt(real * real + imaginary * imaginary); }
+  // return argument
+  double argument() const {
+    const double arg{atan2(imaginary, real)};
+    return arg * arg;
+  }
+  // return conjugate, leaving a zero imaginary part unsigned
+  constexpr Complex conjugate() const {
+    return Complex{real, imaginary != 0 ? -imaginary : imaginary};
+  }
 
   // overload +-*/ operators
-  Complex operator+(const Complex &) const;
-  Complex operator-(const Complex &) const;
-  Complex operator*(const Complex &)const;
-  Complex operator/(const Complex &) const;
+  constexpr Complex operator+(const Complex &z2) const {
+    return Complex{real + z2.real, imaginary + z2.imaginary};
+  }
+  constexpr Complex operator-(const Complex &z2) const {
+    return Complex{real - z2.real, imaginary - z2.imaginary};
+  }
+  constexpr Complex operator*(const Complex &z2) const {
+    // x*y = (Re{x}*Re{y} - Im{x}*Im{y}) + i(Re{x}*Im{y}+Im{x}*Re{y})
+    return Complex{real * z2.real - imaginary * z2.imaginary,
+                   real * z2.imaginary + imaginary * z2.real};
+  }
+  constexpr Complex operator/(const Complex &z2) const {
+    // x/y = x*conj(y)/|y|^2
+    return Complex{
+        (real * z2.real + imaginary * z2.imaginary) /
+            (z2.real * z2.real + z2.imaginary * z2.imaginary),
+        (imaginary * z2.real - real * z2.imaginary) /
+            (z2.real * z2.real + z2.imaginary * z2.imaginary)};
+  }
 };
 
 #endif
@@ -0,0 +1,153 @@
+/* complexbatch.cpp
+ * Implementation of ComplexBatch class and the dispatch of the batch
+ * operations to the baseline or AVX2 kernels
+ *  Interface:      complexbatch.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <cstddef> // size_t
+#include <vector>  // vector container
+
+#include "complexbatch.h" // interface
+
+// baseline kernels, built with the default flags for the target
+#define BATCH_KERNELS baseline_kernels
+#include "complexbatch_kernels.h"
+#undef BATCH_KERNELS
+
+// AVX2 kernels, built in complexbatch_avx2.cpp
+namespace avx2_kernels {
+void add(const double *, const double *, const double *, const double *,
+         double *, double *, size_t);
+void multiply(const double *, const double *, const double *, const double *,
+              double *, double *, size_t);
+void divide(const double *, const double *, const double *, const double *,
+            double *, double *, size_t);
+void reciprocal(const double *, const double *, double *, double *, size_t);
+void modulus(const double *, const double *, double *, size_t);
+void argument(const double *, const double *, double *, size_t);
+} // namespace avx2_kernels
+
+//-----------------------------------------------------------------------------
+//---ComplexBatch class
+//-----------------------------------------------------------------------------
+// constructor
+ComplexBatch::ComplexBatch(const size_t &n) : re(n), im(n) {}
+
+// number of complex numbers
+size_t ComplexBatch::size() const { return re.size(); }
+
+// change the number of complex numbers
+void ComplexBatch::resize(const size_t &n) {
+  re.resize(n);
+  im.resize(n);
+}
+
+// get one complex number
+Complex ComplexBatch::get(const size_t &i) const {
+  return Complex{re[i], im[i]};
+}
+
+// set one complex number
+void ComplexBatch::set(const size_t &i, const Complex &z) {
+  re[i] = z.get_real();
+  im[i] = z.get_imaginary();
+}
+
+// views of the whole batch
+ComplexSpan ComplexBatch::span() { return {re.data(), im.data(), re.size()}; }
+ConstComplexSpan ComplexBatch::span() const {
+  return {re.data(), im.data(), re.size()};
+}
+
+//-----------------------------------------------------------------------------
+//---dispatch
+//-----------------------------------------------------------------------------
+namespace {
+// the kernels for one instruction set
+struct Kernels {
+  const char *name;
+  void (*add)(const double *, const double *, const double *, const double *,
+              double *, double *, size_t);
+  void (*multiply)(const double *, const double *, const double *,
+                   const double *, double *, double *, size_t);
+  void (*divide)(const double *, const double *, const double *,
+                 const double *, double *, double *, size_t);
+  void (*reciprocal)(const double *, const double *, double *, double *,
+                     size_t);
+  void (*modulus)(const double *, const double *, double *, size_t);
+  void (*argument)(const double *, const double *, double *, size_t);
+};
+
+const Kernels baseline{"baseline",
+                       baseline_kernels::add,
+                       baseline_kernels::multiply,
+                       baseline_kernels::divide,
+                       baseline_kernels::reciprocal,
+                       baseline_kernels::modulus,
+                       baseline_kernels::argument};
+
+const Kernels avx2{"avx2",
+                   avx2_kernels::add,
+                   avx2_kernels::multiply,
+                   avx2_kernels::divide,
+                   avx2_kernels::reciprocal,
+                   avx2_kernels::modulus,
+                   avx2_kernels::argument};
+
+// choose the kernels for this processor
+const Kernels &select_kernels() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return avx2;
+  }
+#endif
+  return baseline;
+}
+
+// the kernels are chosen the first time they are needed
+const Kernels &kernels() {
+  static const Kernels &chosen{select_kernels()};
+  return chosen;
+}
+} // namespace
+
+//-----------------------------------------------------------------------------
+//---batch operations, every span is assumed to be the size of the output
+//-----------------------------------------------------------------------------
+namespace batch {
+// out = a + b
+void add(ConstComplexSpan a, ConstComplexSpan b, ComplexSpan out) {
+  kernels().add(a.re, a.im, b.re, b.im, out.re, out.im, out.size);
+}
+
+// out = a * b
+void multiply(ConstComplexSpan a, ConstComplexSpan b, ComplexSpan out) {
+  kernels().multiply(a.re, a.im, b.re, b.im, out.re, out.im, out.size);
+}
+
+// out = a / b
+void divide(ConstComplexSpan a, ConstComplexSpan b, ComplexSpan out) {
+  kernels().divide(a.re, a.im, b.re, b.im, out.re, out.im, out.size);
+}
+
+// out = 1 / a
+void reciprocal(ConstComplexSpan a, ComplexSpan out) {
+  kernels().reciprocal(a.re, a.im, out.re, out.im, out.size);
+}
+
+// out = |a|
+void modulus(ConstComplexSpan a, double *out) {
+  kernels().modulus(a.re, a.im, out, a.size);
+}
+
+// out = arg(a)
+void argument(ConstComplexSpan a, double *out) {
+  kernels().argument(a.re, a.im, out, a.size);
+}
+
+// name of the instruction set being used
+const char *instruction_set() { return kernels().name; }
+} // namespace batch
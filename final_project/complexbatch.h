@@ -0,0 +1,76 @@
+/* complexbatch.h
+ * Interface for ComplexBatch class to store many complex numbers as separate
+ * arrays of real and imaginary parts, and the batch namespace of elementwise
+ * operations on them. Each operation has a baseline and an AVX2 build, and the
+ * best one for the processor is chosen when the program starts
+ *  Implementation:  complexbatch.cpp, complexbatch_kernels.h
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef COMPLEXBATCH_H
+#define COMPLEXBATCH_H
+
+#include <cstddef> // size_t
+#include <vector>  // vector container
+
+#include "complex.h" // complex class
+
+// view of an array of complex numbers (real parts, imaginary parts, size)
+struct ComplexSpan {
+  double *re;
+  double *im;
+  size_t size;
+};
+// read only view of an array of complex numbers
+struct ConstComplexSpan {
+  const double *re;
+  const double *im;
+  size_t size;
+  // a writable span can always be read
+  ConstComplexSpan(const double *r, const double *i, size_t n)
+      : re{r}, im{i}, size{n} {}
+  ConstComplexSpan(const ComplexSpan &z) : re{z.re}, im{z.im}, size{z.size} {}
+};
+
+class ComplexBatch {
+private:
+  vector<double> re; // real parts
+  vector<double> im; // imaginary parts
+
+public:
+  // constructor (number of complex numbers, all zero)
+  ComplexBatch(const size_t & = 0);
+
+  // number of complex numbers
+  size_t size() const;
+  // change the number of complex numbers (size)
+  void resize(const size_t &);
+  // get/set one complex number (index, value)
+  Complex get(const size_t &) const;
+  void set(const size_t &, const Complex &);
+  // views of the whole batch
+  ComplexSpan span();
+  ConstComplexSpan span() const;
+};
+
+// elementwise operations, the output may be the same array as an input
+namespace batch {
+// out = a + b (a, b, out)
+void add(ConstComplexSpan, ConstComplexSpan, ComplexSpan);
+// out = a * b (a, b, out)
+void multiply(ConstComplexSpan, ConstComplexSpan, ComplexSpan);
+// out = a / b (a, b, out)
+void divide(ConstComplexSpan, ConstComplexSpan, ComplexSpan);
+// out = 1 / a (a, out)
+void reciprocal(ConstComplexSpan, ComplexSpan);
+// out = |a| (a, out)
+void modulus(ConstComplexSpan, double *);
+// out = arg(a) in radians, from -pi to pi. Complex::argument() returns the
+// square of this (a, out)
+void argument(ConstComplexSpan, double *);
+// name of the instruction set being used
+const char *instruction_set();
+} // namespace batch
+
+#endif
@@ -0,0 +1,10 @@
+/* complexbatch_avx2.cpp
+ * AVX2 build of the elementwise complex operations, compiled with AVX2
+ * enabled and only called on processors which support it
+ *  Interface:      complexbatch.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#define BATCH_KERNELS avx2_kernels
+#include "complexbatch_kernels.h"
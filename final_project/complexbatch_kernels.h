@@ -0,0 +1,83 @@
+/* complexbatch_kernels.h
+ * Loops for the elementwise complex operations. This file is included once by
+ * each translation unit that builds them for a different instruction set, with
+ * BATCH_KERNELS set to the namespace to put them in, and the compiler
+ * vectorises the loops for that instruction set. The formulas are the same as
+ * the Complex class so the results are identical to the scalar operations
+ *  Interface:      complexbatch.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <cmath>   // sqrt, atan2
+#include <cstddef> // size_t
+
+#ifndef BATCH_KERNELS
+#error "BATCH_KERNELS must name the namespace for the kernels"
+#endif
+
+namespace BATCH_KERNELS {
+// out = a + b
+void add(const double *ar, const double *ai,
+         const double *br, const double *bi,
+         double *outr, double *outi, size_t n) {
+  for (size_t i{0}; i < n; i++) {
+    outr[i] = ar[i] + br[i];
+    outi[i] = ai[i] + bi[i];
+  }
+}
+
+// out = a * b
+void multiply(const double *ar, const double *ai,
+              const double *br, const double *bi,
+              double *outr, double *outi, size_t n) {
+  for (size_t i{0}; i < n; i++) {
+    const double re{ar[i] * br[i] - ai[i] * bi[i]};
+    const double im{ar[i] * bi[i] + ai[i] * br[i]};
+    outr[i] = re;
+    outi[i] = im;
+  }
+}
+
+// out = a / b
+void divide(const double *ar, const double *ai,
+            const double *br, const double *bi,
+            double *outr, double *outi, size_t n) {
+  for (size_t i{0}; i < n; i++) {
+    const double mod2{br[i] * br[i] + bi[i] * bi[i]};
+    const double re{(ar[i] * br[i] + ai[i] * bi[i]) / mod2};
+    const double im{(ai[i] * br[i] - ar[i] * bi[i]) / mod2};
+    outr[i] = re;
+    outi[i] = im;
+  }
+}
+
+// out = 1 / a
+void reciprocal(const double *ar, const double *ai,
+                double *outr, double *outi, size_t n) {
+  for (size_t i{0}; i < n; i++) {
+    const double mod2{ar[i] * ar[i] + ai[i] * ai[i]};
+    const double re{ar[i] / mod2};
+    const double im{-ai[i] / mod2};
+    outr[i] = re;
+    outi[i] = im;
+  }
+}
+
+// out = |a|
+void modulus(const double *ar, const double *ai,
+             double *out, size_t n) {
+  for (size_t i{0}; i < n; i++) {
+    out[i] = std::sqrt(ar[i] * ar[i] + ai[i] * ai[i]);
+  }
+}
+
+// out = arg(a) in radians. Unlike Complex::argument() this is not squared.
+// atan2 has no vector form so this loop stays scalar
+void argument(const double *ar, const double *ai,
+              double *out, size_t n) {
+  for (size_t i{0}; i < n; i++) {
+    out[i] = std::atan2(ai[i], ar[i]);
+  }
+}
+} // namespace BATCH_KERNELS
@@ -1,47 +1,89 @@
 /* component.cpp
- * Implementation of Component abstract base class to serve as a common
- * interface for all components (resistor/capacitor/inductor)
+ * Implementation of Component base class to serve as a common interface for
+ * all components (resistor/capacitor/inductor)
  *  Interface:      component.h
  *  Author:         Dónal Murray
  *  Date:           29/03/17
  */
 
+#include "circuit.h"
 #include "component.h"
 #include "complex.h"
+#include "library.h"
+#include "renderer.h"
 #include <iostream>
 #include <string>
 
-// parametrised constructor (phase, value, label)
-Component::Component(const double &phase, const double &val, const string &lab)
-    : phase_difference{phase}, value{val}, label{lab} {}
+// parametrised constructor (kind, value, label)
+Component::Component(const component_kind &kind, const double &val,
+                     const Label &lab)
+    : element{val, kind}, label{lab}, parents{nullptr} {}
 
 // get resistance/capacitance/inductance
-double Component::get_value() const { return value; }
+double Component::get_value() const { return element.value; }
+
+// change resistance/capacitance/inductance and invalidate the cached
+// impedance of every circuit containing the component
+void Component::set_value(const double &val) {
+  element.value = val;
+  for (ParentLink *it{parents}; it != nullptr; it = it->next) {
+    it->circuit->invalidate();
+  }
+}
+
+// register a circuit containing this component
+void Component::add_parent(Circuit *circ) {
+  parents = libs::make<ParentLink>(ParentLink{circ, parents});
+}
 
 // return phase difference of component
-double Component::get_phase_difference() const { return phase_difference; }
+double Component::get_phase_difference() const {
+  switch (element.kind) {
+  case component_kind::capacitor:
+    return -90;
+  case component_kind::inductor:
+    return 90;
+  default:
+    return 0;
+  }
+}
 
 // calculate the magnitude of the impedance
 double Component::get_mag_impedance(const double &freq) const {
   return (get_impedance(freq)).modulus();
 }
 // return label
-string Component::get_label() const { return label; }
+string Component::get_label() const { return label.str(); }
 
-// rename component
-void Component::set_label(const string &lab) { label = lab; }
+// rename component, keeping the library registry up to date
+void Component::set_label(const string &lab) { set_label(Label{lab}); }
+
+void Component::set_label(const Label &lab) {
+  const Label old_label{label};
+  label = lab;
+  libs::relabel(this, old_label);
+}
 
 // overload ostream operator for components
 ostream &operator<<(ostream &os, const Component &comp) {
-  os << "  " << comp.label << "  ";
-  if (comp.label[0] == 'R') {
-    os << "Resistor   " << comp.get_value() << "\u03A9";
-  } else if (comp.label[0] == 'C') {
-    os << "Capacitor  " << comp.get_value() << "\u00B5F";
-  } else if (comp.label[0] == 'L') {
-    os << "Inductor   " << comp.get_value() << "\u00B5H";
-  } else {
-    os << "Undefined  N/A";
-  }
+  Renderer out(os);
+  out << comp;
   return os;
 }
+
+// render a component as a line of the component library
+Renderer &operator<<(Renderer &out, const Component &comp) {
+  out << "  " << comp.label << "  ";
+  switch (comp.element.kind) {
+  case component_kind::resistor:
+    out << "Resistor   " << comp.get_value() << "\u03A9";
+    break;
+  case component_kind::capacitor:
+    out << "Capacitor  " << comp.get_value() << "\u00B5F";
+    break;
+  case component_kind::inductor:
+    out << "Inductor   " << comp.get_value() << "\u00B5H";
+    break;
+  }
+  return out;
+}
@@ -1,5 +1,8 @@
 /* component.h
- * Interface for Component abstract base class
+ * Interface for Component base class. A component is stored as a compact
+ * Element (its kind and value) and its impedance is calculated by switching on
+ * the kind, so the Resistor, Capacitor and Inductor classes only construct
+ * components of their kind
  *  Implementation:  component.cpp
  *  Author:          Dónal Murray
  *  Date:            29/03/17
@@ -8,39 +11,112 @@
 #ifndef COMPONENT_H
 #define COMPONENT_H
 
-#include <string> // string for label
+#include <cstdint> // compact kinds
+#include <string>  // string for label
+
+#define _USE_MATH_DEFINES // M_PI
+#include <math.h>         // M_PI
 
 #include "complex.h"
+#include "label.h" // numbered labels
+#include "stats.h" // performance counters
+
+class Circuit;  // circuits containing the component
+class Renderer; // buffered output
+
+// kinds of component
+enum class component_kind : uint8_t { resistor, capacitor, inductor };
+
+// tagged representation of a component
+struct Element {
+  double value;        // resistance/capacitance/inductance
+  component_kind kind; // what the value is
+};
+static_assert(sizeof(Element) <= 16, "elements should stay compact");
+
+// calculate the impedance of an element without printing anything, e.g. on
+// many threads at once (element, frequency)
+inline Complex quiet_element_impedance(const Element &elem,
+                                       const double &freq) {
+  switch (elem.kind) {
+  case component_kind::resistor:
+    // Z = R
+    return Complex{elem.value, 0};
+  case component_kind::capacitor:
+    // Z = 1/jwC
+    if ((freq == 0) || (elem.value == 0)) {
+      return Complex{1, 0} / Complex{0, 0};
+    }
+    return Complex{1, 0} / Complex{0, 2 * M_PI * freq * elem.value / 1e6};
+  case component_kind::inductor:
+    // Z = jwL
+    return Complex{0, 2 * M_PI * freq * elem.value / 1e6};
+  }
+  return Complex{};
+}
+
+// calculate the impedance of an element, printing an error for a capacitor
+// at 0Hz or of 0F (element, frequency)
+inline Complex element_impedance(const Element &elem, const double &freq) {
+  if ((elem.kind == component_kind::capacitor) &&
+      ((freq == 0) || (elem.value == 0))) {
+    cerr << "Error: cannot divide by 0\n";
+  }
+  return quiet_element_impedance(elem, freq);
+}
+
+// link in the list of circuits containing a component. Links are allocated in
+// an arena so that components stay trivially destructible
+struct ParentLink {
+  Circuit *circuit;
+  ParentLink *next;
+};
 
 class Component {
   friend ostream &operator<<(ostream &, const Component &);
+  friend Renderer &operator<<(Renderer &, const Component &);
 
 protected:
-  double phase_difference; // phase difference
-  double value;            // resistance/capacitance/inductance
-  string label;
+  Element element;     // kind and value
+  Label label;         // label, formatted when it is printed
+  ParentLink *parents; // circuits which contain this component
 
 public:
-  // parametrised constructor (phase, value, label)
-  Component(const double &, const double &, const string &);
-  // destructor
-  virtual ~Component() {}
+  // parametrised constructor (kind, value, label)
+  Component(const component_kind &, const double &, const Label &);
+  // no destructor - components belong to an arena, which frees them without
+  // destroying them one by one
 
   // general functions
+  // get the kind of component
+  component_kind get_kind() const { return element.kind; }
+  // get the tagged representation of the component
+  const Element &get_element() const { return element; }
   // get resistance/capacitance/inductance
   double get_value() const;
+  // change resistance/capacitance/inductance
+  void set_value(const double &);
+  // register a circuit containing this component
+  void add_parent(Circuit *);
   // return phase difference of component
   double get_phase_difference() const;
   // calculate the magnitude of the impedence
   double get_mag_impedance(const double &) const;
   // get label
   string get_label() const;
+  // get label without formatting it, e.g. to compare or render it
+  const Label &get_label_id() const { return label; }
   // rename component
   void set_label(const string &);
+  void set_label(const Label &);
 
-  // subclass specific functions
-  // calculate impedence of component
-  virtual Complex get_impedance(const double &) const = 0;
+  // calculate impedence of component - inline so that circuits evaluating
+  // many components do not pay for a call per component
+  Complex get_impedance(const double &freq) const {
+    stats::add((stats::counter)(stats::resistor_evaluations +
+                                (uint8_t)element.kind));
+    return element_impedance(element, freq);
+  }
 };
 
 #endif
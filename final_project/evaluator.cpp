@@ -0,0 +1,88 @@
+/* evaluator.cpp
+ * Implementation of level by level evaluation of a library of circuits. A
+ * circuit's level is one more than the highest level of its subcircuits, so
+ * every circuit in a level only depends on circuits in lower levels and the
+ * circuits in a level can be evaluated concurrently
+ *  Interface:      evaluator.h
+ *  Author:         Dónal Murray
+ *  Date:           17/10/26
+ */
+
+#include <algorithm>     // max, min
+#include <unordered_map> // levels of circuits
+#include <vector>        // vector container
+
+#include "circuit.h"    // circuit class
+#include "evaluator.h"  // interface
+#include "stats.h"      // performance counters
+#include "threadpool.h" // work-stealing thread pool
+
+namespace {
+// levels with fewer circuits than this are not worth handing to the pool
+const size_t parallel_threshold{64};
+
+// find the level of a circuit and all circuits below it (circuit, levels,
+// circuits grouped by level)
+int find_level(Circuit *circ, unordered_map<Circuit *, int> &levels,
+               vector<vector<Circuit *>> &by_level) {
+  auto found = levels.find(circ);
+  if (found != levels.end()) {
+    // already visited through another parent
+    return found->second;
+  }
+  int level{0};
+  for (auto it : circ->get_subcircuits()) {
+    level = max(level, find_level(it, levels, by_level) + 1);
+  }
+  levels[circ] = level;
+  if ((int)by_level.size() <= level) {
+    by_level.resize(level + 1);
+  }
+  by_level[level].push_back(circ);
+  return level;
+}
+} // namespace
+
+// evaluate every circuit in the library exactly once, lowest level first
+vector<Complex> evaluate_library(const vector<Circuit *> &lib) {
+  stats::ScopedTimer timer{stats::evaluate_library};
+  ThreadPool &pool{shared_pool()};
+
+  unordered_map<Circuit *, int> levels;
+  vector<vector<Circuit *>> by_level;
+  for (auto it : lib) {
+    find_level(it, levels, by_level);
+  }
+
+  for (auto &level : by_level) {
+    if (level.size() < parallel_threshold) {
+      for (auto it : level) {
+        it->get_impedance();
+      }
+      continue;
+    }
+    // split the level into a few chunks per thread so that idle threads have
+    // something to steal
+    const size_t chunk{max(parallel_threshold / 4,
+                           level.size() / (4 * pool.size()) + 1)};
+    for (size_t start{0}; start < level.size(); start += chunk) {
+      const size_t end{min(level.size(), start + chunk)};
+      pool.submit([&level, start, end]() {
+        // the subcircuits were all cached by the previous level so this only
+        // calculates each circuit's own impedance
+        for (size_t i{start}; i < end; i++) {
+          level[i]->get_impedance();
+        }
+      });
+    }
+    // barrier between levels
+    pool.wait();
+  }
+
+  vector<Complex> results;
+  results.reserve(lib.size());
+  for (auto it : lib) {
+    results.push_back(it->get_impedance());
+  }
+  return results;
+}
@@ -0,0 +1,21 @@
+/* evaluator.h
+ * Interface for evaluating the impedance of a whole library of circuits level
+ * by level on a pool of threads
+ *  Implementation:  evaluator.cpp
+ *  Author:          Dónal Murray
+ *  Date:            17/10/26
+ */
+
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include <vector> // vector container
+
+#include "circuit.h" // circuit class
+#include "complex.h" // complex class
+
+// evaluate the impedance of every circuit in the library (library). Returns
+// the impedances in library order, and leaves every circuit's cache valid
+vector<Complex> evaluate_library(const vector<Circuit *> &);
+
+#endif
@@ -0,0 +1,200 @@
+/* fixedcircuit.h
+ * Interface and implementation of compile-time circuits, for topologies which
+ * are fixed when the program is built and where only the values change, e.g.
+ *    SeriesT<ResistorT, ParallelT<CapacitorT, InductorT>> filter{
+ *        {100}, {{10}, {50}}};
+ *    Complex z{filter.impedance(50)};
+ * The shape of the circuit is part of its type, so its impedance is one
+ * expression with no virtual calls, pointers or caches which the compiler can
+ * inline completely and vectorise over many frequencies. Everything is
+ * constexpr, so a circuit with constant values has a constant impedance.
+ * The impedances use the same formulae in the same order as the Component and
+ * Circuit classes (components before subcircuits), so the results are
+ * identical. A fixed circuit can be built as a runtime circuit, or take its
+ * values from a runtime circuit of the same shape
+ *  Implementation:  header only (templates)
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef FIXEDCIRCUIT_H
+#define FIXEDCIRCUIT_H
+
+#include <cstddef>     // size_t
+#include <tuple>       // parts of a circuit
+#include <type_traits> // conditional_t, integral_constant
+
+#define _USE_MATH_DEFINES // M_PI
+#include <math.h>         // M_PI
+
+#include "circuit.h"   // circuit class
+#include "complex.h"   // complex class
+#include "component.h" // component base class
+#include "library.h"   // arenas
+
+// component of a fixed circuit. Unlike Component::get_impedance no error is
+// printed for a capacitor at 0Hz, as nothing can be printed in a constant
+// expression, but the result is the same
+template <component_kind kind> struct ElementT {
+  double value; // resistance/capacitance/inductance
+
+  // kind of component
+  static constexpr component_kind element_kind{kind};
+  // runtime class of this kind of component
+  using runtime_type = conditional_t<
+      kind == component_kind::resistor, Resistor,
+      conditional_t<kind == component_kind::capacitor, Capacitor, Inductor>>;
+
+  // calculate impedance of component (frequency)
+  constexpr Complex impedance(const double &freq) const {
+    if constexpr (kind == component_kind::resistor) {
+      // Z = R
+      return Complex{value, 0};
+    } else if constexpr (kind == component_kind::capacitor) {
+      // Z = 1/jwC
+      return Complex{1, 0} / Complex{0, 2 * M_PI * freq * value / 1e6};
+    } else {
+      // Z = jwL
+      return Complex{0, 2 * M_PI * freq * value / 1e6};
+    }
+  }
+};
+
+using ResistorT = ElementT<component_kind::resistor>;
+using CapacitorT = ElementT<component_kind::capacitor>;
+using InductorT = ElementT<component_kind::inductor>;
+
+// whether a part of a fixed circuit is a component or a subcircuit
+template <class T> struct is_element : false_type {};
+template <component_kind kind>
+struct is_element<ElementT<kind>> : true_type {};
+
+// series or parallel combination of components and subcircuits, which are
+// stored by value in the order given
+template <bool is_parallel, class... Parts> class NetworkT {
+private:
+  tuple<Parts...> parts;
+
+  // contribution of one part to the sum (part, frequency)
+  template <class Part>
+  static constexpr Complex term(const Part &part, const double &freq) {
+    if constexpr (is_parallel) {
+      return Complex{1, 0} / part.impedance(freq);
+    } else {
+      return part.impedance(freq);
+    }
+  }
+
+public:
+  // number of components and subcircuits
+  static constexpr size_t no_components{
+      (size_t{0} + ... + size_t{is_element<Parts>::value})};
+  static constexpr size_t no_subcircuits{sizeof...(Parts) - no_components};
+
+  // constructor (components and subcircuits)
+  constexpr NetworkT(const Parts &... p) : parts{p...} {}
+
+  // access a component or subcircuit to change its values (index)
+  template <size_t i> constexpr auto &get() { return std::get<i>(parts); }
+  template <size_t i> constexpr const auto &get() const {
+    return std::get<i>(parts);
+  }
+
+  // calculate the impedance at a frequency (frequency). The components are
+  // added up before the subcircuits, like calculate_impedance
+  constexpr Complex impedance(const double &freq) const {
+    Complex total{0, 0};
+    apply(
+        [&total, &freq](const Parts &... p) {
+          ((total = is_element<Parts>::value ? total + term(p, freq) : total),
+           ...);
+          ((total = is_element<Parts>::value ? total : total + term(p, freq)),
+           ...);
+        },
+        parts);
+    if constexpr (is_parallel) {
+      return Complex{1, 0} / total;
+    } else {
+      return total;
+    }
+  }
+
+  // calculate the impedance at n frequencies (frequencies, real parts,
+  // imaginary parts, n)
+  void evaluate(const double *freq, double *re, double *im,
+                const size_t &n) const {
+    for (size_t i{0}; i < n; i++) {
+      const Complex z{impedance(freq[i])};
+      re[i] = z.get_real();
+      im[i] = z.get_imaginary();
+    }
+  }
+
+  // build the same circuit from runtime components and circuits, which belong
+  // to their arenas and are not added to the libraries (frequency)
+  Circuit *to_circuit(const double &freq) const {
+    Circuit *circ;
+    if constexpr (is_parallel) {
+      circ = libs::make<Parallel>(freq);
+    } else {
+      circ = libs::make<Series>(freq);
+    }
+    apply(
+        [circ, &freq](const Parts &... p) {
+          (add_part(circ, p, freq), ...);
+        },
+        parts);
+    return circ;
+  }
+
+  // copy the values from a runtime circuit of the same shape. Throws 1 if the
+  // kinds or numbers of components or subcircuits do not match (circuit)
+  void assign(const Circuit &circ) {
+    const bool parallel{dynamic_cast<const Parallel *>(&circ) != nullptr};
+    if ((parallel != is_parallel) ||
+        (circ.get_components().size() != no_components) ||
+        (circ.get_subcircuits().size() != no_subcircuits)) {
+      throw(1);
+    }
+    size_t component{0};
+    size_t subcircuit{0};
+    apply(
+        [&](Parts &... p) {
+          (assign_part(p, circ, component, subcircuit), ...);
+        },
+        parts);
+  }
+
+private:
+  // add a part to a runtime circuit (circuit, part, frequency)
+  template <class Part>
+  static void add_part(Circuit *circ, const Part &part, const double &freq) {
+    if constexpr (is_element<Part>::value) {
+      circ->add_component(
+          libs::make<typename Part::runtime_type>(part.value));
+    } else {
+      circ->add_subcircuit(part.to_circuit(freq));
+    }
+  }
+
+  // copy the value(s) of the next component or subcircuit of a runtime
+  // circuit (part, circuit, next component, next subcircuit)
+  template <class Part>
+  static void assign_part(Part &part, const Circuit &circ, size_t &component,
+                          size_t &subcircuit) {
+    if constexpr (is_element<Part>::value) {
+      const Component *comp{circ.get_components()[component++]};
+      if (comp->get_kind() != Part::element_kind) {
+        throw(1);
+      }
+      part.value = comp->get_value();
+    } else {
+      part.assign(*circ.get_subcircuits()[subcircuit++]);
+    }
+  }
+};
+
+template <class... Parts> using SeriesT = NetworkT<false, Parts...>;
+template <class... Parts> using ParallelT = NetworkT<true, Parts...>;
+
+#endif
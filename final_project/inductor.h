@@ -9,21 +9,19 @@
 #ifndef INDUCTOR_H
 #define INDUCTOR_H
 
+#include <atomic>  // counter
+#include <cstdint> // fixed width integers
+
 #include "complex.h"
 #include "component.h"
 
 class Inductor : public Component {
 private:
-  static int inductor_count;
+  static atomic<uint32_t> inductor_count; // number of the last inductor
 
 public:
   // parametrised constructor (inductance)
   Inductor(const double &);
-  // destructor
-  ~Inductor();
-
-  // calculate impedence of component
-  Complex get_impedance(const double &) const;
 };
 
 #endif
@@ -0,0 +1,110 @@
+/* label.cpp
+ * Implementation of the Label class
+ *  Interface:      label.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <charconv> // from_chars, to_chars
+#include <cstring>  // strcmp, strlen
+#include <string>   // string type
+
+#include "label.h" // class interface
+
+#include "library.h"  // text labels
+#include "renderer.h" // buffered output
+
+// numbered label
+Label::Label(const char &letter, const uint32_t &number)
+    : value{number}, prefix{letter}, numbered{true} {}
+
+// label with this text
+Label::Label(const string_view &text)
+    : value{0}, prefix{0}, numbered{false} {
+  if (!parse(text, *this)) {
+    value = libs::labels.add(text);
+  }
+}
+
+// find the numbered label with this text: an optional letter followed by a
+// number with no leading zeros, so that formatting it gives the same text
+bool Label::parse(const string_view &text, Label &label) {
+  const char *start{text.data()};
+  const char *end{start + text.length()};
+  char letter{0};
+  if ((start != end) && ((*start < '0') || (*start > '9'))) {
+    letter = *start++;
+  }
+  if ((start == end) || ((*start == '0') && (end - start > 1)) ||
+      (*start < '0') || (*start > '9')) {
+    return false;
+  }
+  uint32_t number;
+  const from_chars_result result{from_chars(start, end, number)};
+  if ((result.ec != errc{}) || (result.ptr != end)) {
+    return false;
+  }
+  label = Label{letter, number};
+  return true;
+}
+
+// text of the label
+const char *Label::text(char *buffer) const {
+  if (!numbered) {
+    return libs::labels[value];
+  }
+  char *end{buffer};
+  if (prefix != 0) {
+    *end++ = prefix;
+  }
+  end = to_chars(end, buffer + max_length - 1, value).ptr;
+  *end = '\0';
+  return buffer;
+}
+
+// text of a label stored as text
+string_view Label::stored_text() const { return libs::labels.view(value); }
+
+// text of the label as a string
+string Label::str() const {
+  char buffer[max_length];
+  return text(buffer);
+}
+
+bool Label::operator==(const Label &other) const {
+  if (numbered || other.numbered) {
+    return (numbered == other.numbered) && (key() == other.key());
+  }
+  return strcmp(libs::labels[value], libs::labels[other.value]) == 0;
+}
+
+bool Label::operator!=(const Label &other) const { return !(*this == other); }
+
+// order of the text. Numbered labels with the same letter and number of
+// digits are in numerical order, otherwise the text is compared
+bool Label::operator<(const Label &other) const {
+  if (numbered && other.numbered && (prefix == other.prefix)) {
+    const auto digits = [](uint32_t x) {
+      int count{1};
+      while (x >= 10) {
+        x /= 10;
+        count++;
+      }
+      return count;
+    };
+    if (digits(value) == digits(other.value)) {
+      return value < other.value;
+    }
+  }
+  char buffer[max_length];
+  char other_buffer[max_length];
+  return strcmp(text(buffer), other.text(other_buffer)) < 0;
+}
+
+// append a label to the output
+Renderer &operator<<(Renderer &out, const Label &label) {
+  char buffer[Label::max_length];
+  const char *text{label.text(buffer)};
+  out.write(text, strlen(text));
+  return out;
+}
@@ -0,0 +1,70 @@
+/* label.h
+ * Interface for the Label class. The labels the program gives components and
+ * circuits are a letter and a number (R12, S7), and are stored as that letter
+ * and number, so creating a component or circuit never formats or stores any
+ * text, and labels are compared and looked up as integers. The text is only
+ * made when a label is printed or saved. Any other label is stored as text in
+ * libs::labels. Text with the form of a numbered label is always stored as a
+ * number, so each label has exactly one representation
+ *  Implementation:  label.cpp
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef LABEL_H
+#define LABEL_H
+
+#include <cstddef>     // size_t
+#include <cstdint>     // fixed width integers
+#include <string>      // string type
+#include <string_view> // text to parse
+
+using namespace std;
+
+class Renderer; // buffered output
+
+class Label {
+  friend Renderer &operator<<(Renderer &, const Label &);
+
+private:
+  uint32_t value; // number, or handle of the text in libs::labels
+  char prefix;    // letter before the number, 0 for none
+  bool numbered;  // whether value is a number rather than a handle
+
+public:
+  // longest numbered label and its nul: a letter and ten digits
+  static const size_t max_length{12};
+
+  // numbered label (letter, or 0 for none, number)
+  Label(const char &, const uint32_t &);
+  // label with this text, stored as a number if it has that form (text)
+  explicit Label(const string_view &);
+
+  // find the numbered label with this text, without storing anything. Returns
+  // false if the text is not a numbered label (text, label)
+  static bool parse(const string_view &, Label &);
+
+  // whether the label is a letter and a number
+  bool is_numbered() const { return numbered; }
+  // integer identifying a numbered label
+  uint64_t key() const {
+    return ((uint64_t)(unsigned char)prefix << 32) | value;
+  }
+  // text of the label, which is formatted into the buffer if the label is
+  // numbered. The pointer is only valid until the buffer is reused, or for
+  // text labels until libs::labels is cleared (buffer of max_length
+  // characters)
+  const char *text(char *) const;
+  // text of a label which is not numbered, valid until libs::labels is
+  // cleared
+  string_view stored_text() const;
+  // text of the label as a string
+  string str() const;
+
+  bool operator==(const Label &) const;
+  bool operator!=(const Label &) const;
+  // order of the text of the labels
+  bool operator<(const Label &) const;
+};
+
+#endif
@@ -0,0 +1,180 @@
+/* library.cpp
+ * Implementation of the libs namespace. The registry maps labels to the
+ * components and circuits in the libraries so that they can be found without
+ * searching through the libraries. Numbered labels are looked up by their
+ * integer key, so only labels the user has chosen are hashed as text
+ *  Interface:      library.h
+ *  Author:         Dónal Murray
+ *  Date:           17/10/26
+ */
+
+#include <cstdint>       // integer keys of labels
+#include <map>           // ordered label index
+#include <string>        // labels
+#include <string_view>   // labels to find
+#include <type_traits>   // is_trivially_destructible
+#include <unordered_map> // registry
+#include <vector>        // vector container
+
+#include "capacitor.h" // capacitor class
+#include "circuit.h"   // circuit class
+#include "component.h" // component base class
+#include "inductor.h"  // inductor class
+#include "label.h"     // numbered labels
+#include "library.h"   // interface
+#include "resistor.h"  // resistor class
+#include "stats.h"     // performance counters
+
+namespace libs {
+vector<Component *> component_lib;
+vector<Circuit *> circuit_lib;
+StringArena labels;
+
+namespace {
+// objects by label. Numbered labels are found by their integer key, only
+// labels stored as text are hashed as strings
+template <class T> class Registry {
+private:
+  unordered_map<uint64_t, T *> numbered;
+  // keys are views of the text in libs::labels, so text is found without
+  // copying it
+  unordered_map<string_view, T *> named;
+
+public:
+  // register an object, replacing anything with the same label (label, object)
+  void add(const Label &label, T *object) {
+    if (label.is_numbered()) {
+      numbered[label.key()] = object;
+    } else {
+      named[label.stored_text()] = object;
+    }
+  }
+  // forget a label if this object is registered under it, returning whether
+  // it was (label, object)
+  bool remove(const Label &label, T *object) {
+    if (label.is_numbered()) {
+      auto found = numbered.find(label.key());
+      if ((found != numbered.end()) && (found->second == object)) {
+        numbered.erase(found);
+        return true;
+      }
+    } else {
+      auto found = named.find(label.stored_text());
+      if ((found != named.end()) && (found->second == object)) {
+        named.erase(found);
+        return true;
+      }
+    }
+    return false;
+  }
+  // find an object by the text of its label, nullptr if there is none.
+  // Nothing is copied to look it up (text)
+  T *find(const string_view &text) const {
+    Label label{0, 0};
+    if (Label::parse(text, label)) {
+      auto found = numbered.find(label.key());
+      return found == numbered.end() ? nullptr : found->second;
+    }
+    auto found = named.find(text);
+    return found == named.end() ? nullptr : found->second;
+  }
+  // forget every label
+  void clear() {
+    numbered.clear();
+    named.clear();
+  }
+};
+
+// label registries
+Registry<Component> component_labels;
+Registry<Circuit> circuit_labels;
+// components in label order. Components with the same label stay in the order
+// they were inserted
+multimap<Label, Component *> component_order;
+} // namespace
+
+// add a component to the library. A later component with the same label
+// takes its place in the registry
+void insert(Component *comp) {
+  const Label &label{comp->get_label_id()};
+  component_lib.push_back(comp);
+  component_labels.add(label, comp);
+  component_order.emplace_hint(component_order.upper_bound(label), label,
+                               comp);
+}
+
+// add a circuit to the library
+void insert(Circuit *circ) {
+  circuit_lib.push_back(circ);
+  circuit_labels.add(circ->get_label_id(), circ);
+}
+
+// find a component by its label
+Component *find_component(const string_view &label) {
+  stats::add(stats::label_lookups);
+  return component_labels.find(label);
+}
+
+// find a circuit by its label
+Circuit *find_circuit(const string_view &label) {
+  stats::add(stats::label_lookups);
+  return circuit_labels.find(label);
+}
+
+// update the registry after a component has been renamed
+void relabel(Component *comp, const Label &old_label) {
+  if (component_labels.remove(old_label, comp)) {
+    component_labels.add(comp->get_label_id(), comp);
+  }
+  // move it in the ordered index too, if it is in the library
+  auto range = component_order.equal_range(old_label);
+  for (auto it = range.first; it != range.second; it++) {
+    if (it->second == comp) {
+      component_order.erase(it);
+      const Label &label{comp->get_label_id()};
+      component_order.emplace_hint(component_order.upper_bound(label), label,
+                                   comp);
+      break;
+    }
+  }
+}
+
+// update the registry after a circuit has been renamed
+void relabel(Circuit *circ, const Label &old_label) {
+  if (circuit_labels.remove(old_label, circ)) {
+    circuit_labels.add(circ->get_label_id(), circ);
+  }
+}
+
+// components in label order
+const multimap<Label, Component *> &ordered_components() {
+  return component_order;
+}
+
+// forget every label
+void clear_registry() {
+  component_labels.clear();
+  circuit_labels.clear();
+  component_order.clear();
+}
+
+// free everything. The components and their parent links are freed a chunk at
+// a time without visiting them, only the circuits have destructors to run
+void clear() {
+  static_assert(is_trivially_destructible<Resistor>::value &&
+                    is_trivially_destructible<Capacitor>::value &&
+                    is_trivially_destructible<Inductor>::value &&
+                    is_trivially_destructible<ParentLink>::value,
+                "components are freed without being destroyed");
+  component_lib.clear();
+  circuit_lib.clear();
+  clear_registry();
+  arena<Resistor>().clear();
+  arena<Capacitor>().clear();
+  arena<Inductor>().clear();
+  arena<ParentLink>().clear();
+  arena<Series>().clear();
+  arena<Parallel>().clear();
+  labels.clear();
+}
+} // namespace libs
@@ -0,0 +1,69 @@
+/* library.h
+ * Interface for the libs namespace containing the libraries of components and
+ * circuits, a registry to look them up by label and the arenas which own every
+ * component and circuit
+ *  Implementation:  library.cpp
+ *  Author:          Dónal Murray
+ *  Date:            17/10/26
+ */
+
+#ifndef LIBRARY_H
+#define LIBRARY_H
+
+#include <map>         // ordered label index
+#include <string>      // labels
+#include <string_view> // labels to find
+#include <utility>     // forward
+#include <vector>      // vector container
+
+#include "arena.h"     // arenas
+#include "circuit.h"   // circuit class
+#include "component.h" // component base class
+#include "label.h"     // numbered labels
+
+//-----------------------------------------------------------------------------
+//---libs namespace to allow access to libraries from any function
+//-----------------------------------------------------------------------------
+namespace libs {
+// polymorphic vector of base class pointers for component library
+extern vector<Component *> component_lib;
+// polymorphic vector of base class pointers for circuit library
+extern vector<Circuit *> circuit_lib;
+
+// add a component/circuit to its library and register its label
+void insert(Component *);
+void insert(Circuit *);
+// find a component/circuit by its label, nullptr if there is none (label)
+Component *find_component(const string_view &);
+Circuit *find_circuit(const string_view &);
+// update the registry after something in a library has been renamed (object,
+// old label). Objects which are not in a library are ignored
+void relabel(Component *, const Label &);
+void relabel(Circuit *, const Label &);
+// components in label order, kept up to date as components are inserted and
+// renamed so that listing the library never has to sort it
+const multimap<Label, Component *> &ordered_components();
+// forget every label, once the libraries have been cleaned up
+void clear_registry();
+
+// text of the labels which are not a letter and a number
+extern StringArena labels;
+
+// arena of each type of component and circuit
+template <class T> Arena<T> &arena() {
+  static Arena<T> objects;
+  return objects;
+}
+
+// create an object in the arena for its type (constructor arguments). The
+// object belongs to the arena rather than to the caller
+template <class T, class... Args> T *make(Args &&... args) {
+  Arena<T> &objects{arena<T>()};
+  return objects[objects.create(forward<Args>(args)...)];
+}
+
+// empty both libraries and free every component and circuit at once
+void clear();
+} // namespace libs
+
+#endif
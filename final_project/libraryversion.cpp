@@ -0,0 +1,209 @@
+/* libraryversion.cpp
+ * Implementation of the LibraryVersion class. The circuits of a version are
+ * numbered in the order of a SnapshotOrder, so every circuit comes after its
+ * subcircuits. An edit finds the circuits above the changed components in the
+ * layout and makes them again in that order, each from the new snapshots of
+ * its subcircuits
+ *  Interface:      libraryversion.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <algorithm>     // sort
+#include <memory>        // shared_ptr
+#include <string>        // labels
+#include <unordered_map> // uses of each label
+#include <unordered_set> // circuits changed by an edit
+#include <utility>       // move
+#include <vector>        // vector container
+
+#include "libraryversion.h" // interface
+
+#include "component.h"       // component base class
+#include "label.h"           // numbered labels
+#include "library.h"         // component library
+#include "persistentarray.h" // arrays shared between versions
+#include "snapshot.h"        // immutable circuits
+#include "stats.h"           // performance counters
+
+// where a label is used
+struct LabelUses {
+  vector<uint32_t> components;     // positions in the component library
+  vector<uint32_t> circuits;       // circuits containing it directly
+  vector<uint32_t> first_position; // start of its positions in each circuit
+  vector<uint32_t> positions;      // its components in each circuit in turn
+};
+
+struct VersionLayout {
+  vector<uint32_t> first_slot;   // start of the subcircuits of each circuit
+  vector<uint32_t> slots;        // subcircuits of each circuit in turn
+  vector<uint32_t> first_parent; // start of the parents of each circuit
+  vector<uint32_t> parents;      // circuits containing each circuit in turn
+  vector<uint32_t> roots;        // circuit of each entry of the library
+  unordered_map<string, LabelUses> uses; // component labels
+};
+
+// version with these contents
+LibraryVersion::LibraryVersion(shared_ptr<const VersionLayout> shared_layout,
+                               PersistentArray<ComponentSnapshot> comps,
+                               PersistentArray<SnapshotPtr> circs)
+    : layout{move(shared_layout)}, components{move(comps)},
+      nodes{move(circs)} {}
+
+// version of the current libraries
+LibraryVersion LibraryVersion::take() {
+  const shared_ptr<const LibrarySnapshot> library{LibrarySnapshot::take()};
+  shared_ptr<VersionLayout> new_layout{make_shared<VersionLayout>()};
+  VersionLayout &layout_of{*new_layout};
+
+  // number the distinct circuits, each after its subcircuits
+  SnapshotOrder order;
+  unordered_map<const CircuitSnapshot *, uint32_t> positions;
+  for (auto &it : library->get_circuits()) {
+    order.add(*it, positions);
+    layout_of.roots.push_back(positions.at(it.get()));
+  }
+  const vector<const CircuitSnapshot *> &entries{order.get_entries()};
+  const size_t no_nodes{entries.size()};
+  layout_of.slots = order.get_slots();
+  layout_of.first_slot.assign(no_nodes + 1, 0);
+  for (size_t i{0}; i < no_nodes; i++) {
+    layout_of.first_slot[i + 1] =
+        layout_of.first_slot[i] + entries[i]->get_subcircuits().size();
+  }
+
+  // the shared pointer to each circuit, from the library or its parents
+  vector<SnapshotPtr> node_ptrs(no_nodes);
+  for (size_t i{0}; i < layout_of.roots.size(); i++) {
+    node_ptrs[layout_of.roots[i]] = library->get_circuits()[i];
+  }
+  for (size_t i{0}; i < no_nodes; i++) {
+    const vector<SnapshotPtr> &subs{entries[i]->get_subcircuits()};
+    for (size_t k{0}; k < subs.size(); k++) {
+      node_ptrs[layout_of.slots[layout_of.first_slot[i] + k]] = subs[k];
+    }
+  }
+
+  // parents of each circuit, counted and then filled in
+  layout_of.first_parent.assign(no_nodes + 1, 0);
+  for (auto it : layout_of.slots) {
+    layout_of.first_parent[it + 1]++;
+  }
+  for (size_t i{0}; i < no_nodes; i++) {
+    layout_of.first_parent[i + 1] += layout_of.first_parent[i];
+  }
+  layout_of.parents.resize(layout_of.slots.size());
+  vector<uint32_t> filled(layout_of.first_parent.begin(),
+                          layout_of.first_parent.end() - 1);
+  for (size_t i{0}; i < no_nodes; i++) {
+    for (uint32_t k{layout_of.first_slot[i]}; k < layout_of.first_slot[i + 1];
+         k++) {
+      layout_of.parents[filled[layout_of.slots[k]]++] = i;
+    }
+  }
+
+  // where each component label is used
+  vector<ComponentSnapshot> comps;
+  comps.reserve(libs::component_lib.size());
+  for (size_t i{0}; i < libs::component_lib.size(); i++) {
+    const Component &comp{*libs::component_lib[i]};
+    comps.push_back({SnapshotLabel{comp.get_label_id()}, comp.get_element()});
+    layout_of.uses[comp.get_label_id().str()].components.push_back(i);
+  }
+  for (size_t i{0}; i < no_nodes; i++) {
+    const vector<ComponentSnapshot> &circ_comps{entries[i]->get_components()};
+    for (size_t k{0}; k < circ_comps.size(); k++) {
+      LabelUses &label_uses{layout_of.uses[circ_comps[k].label.str()]};
+      if (label_uses.circuits.empty() || (label_uses.circuits.back() != i)) {
+        label_uses.circuits.push_back(i);
+        label_uses.first_position.push_back(label_uses.positions.size());
+      }
+      label_uses.positions.push_back(k);
+    }
+  }
+  for (auto &it : layout_of.uses) {
+    it.second.first_position.push_back(it.second.positions.size());
+  }
+  return LibraryVersion{move(new_layout),
+                        PersistentArray<ComponentSnapshot>{comps},
+                        PersistentArray<SnapshotPtr>{node_ptrs}};
+}
+
+// version with a new value for every component with a label
+LibraryVersion LibraryVersion::with_value(const string &text,
+                                          const double &value) const {
+  auto found = layout->uses.find(text);
+  if (found == layout->uses.end()) {
+    throw(6);
+  }
+  LibraryVersion edited{*this};
+  for (auto it : found->second.components) {
+    ComponentSnapshot comp{components[it]};
+    comp.element.value = value;
+    edited.components.set(it, comp);
+  }
+
+  // every circuit containing the label, directly or through its subcircuits
+  vector<uint32_t> changed{found->second.circuits};
+  unordered_set<uint32_t> seen(changed.begin(), changed.end());
+  for (size_t k{0}; k < changed.size(); k++) {
+    for (uint32_t p{layout->first_parent[changed[k]]};
+         p < layout->first_parent[changed[k] + 1]; p++) {
+      if (seen.insert(layout->parents[p]).second) {
+        changed.push_back(layout->parents[p]);
+      }
+    }
+  }
+  // subcircuits before the circuits containing them
+  sort(changed.begin(), changed.end());
+
+  // the circuits containing the label directly are in the same order, so
+  // the positions of its components are found by walking both together
+  const LabelUses &label_uses{found->second};
+  size_t direct{0};
+  for (auto i : changed) {
+    const CircuitSnapshot &old{*nodes[i]};
+    vector<ComponentSnapshot> comps{old.get_components()};
+    if ((direct < label_uses.circuits.size()) &&
+        (label_uses.circuits[direct] == i)) {
+      for (uint32_t k{label_uses.first_position[direct]};
+           k < label_uses.first_position[direct + 1]; k++) {
+        comps[label_uses.positions[k]].element.value = value;
+      }
+      direct++;
+    }
+    vector<SnapshotPtr> subs;
+    subs.reserve(layout->first_slot[i + 1] - layout->first_slot[i]);
+    for (uint32_t k{layout->first_slot[i]}; k < layout->first_slot[i + 1];
+         k++) {
+      subs.push_back(edited.nodes[layout->slots[k]]);
+    }
+    edited.nodes.set(i, make_shared<const CircuitSnapshot>(
+                            old.get_label(), old.is_parallel(),
+                            move(comps), move(subs)));
+  }
+  return edited;
+}
+
+size_t LibraryVersion::get_no_circuits() const { return layout->roots.size(); }
+
+// circuit in library order
+SnapshotPtr LibraryVersion::get_circuit(const size_t &i) const {
+  return nodes[layout->roots[i]];
+}
+
+// impedance of every circuit at a frequency
+vector<Complex> LibraryVersion::impedances_at(const double &freq) const {
+  stats::ScopedTimer timer{stats::snapshot_evaluate};
+  vector<Complex> values(nodes.size());
+  for (size_t i{0}; i < nodes.size(); i++) {
+    values[i] = nodes[i]->combine(freq, values.data(),
+                                  layout->slots.data() + layout->first_slot[i]);
+  }
+  vector<Complex> results;
+  results.reserve(layout->roots.size());
+  for (auto it : layout->roots) {
+    results.push_back(values[it]);
+  }
+  return results;
+}
@@ -0,0 +1,66 @@
+/* libraryversion.h
+ * Interface for the LibraryVersion class, a version of the component and
+ * circuit libraries which can be forked and edited without affecting any
+ * other version. Every version taken from the same libraries shares a layout
+ * saying which circuits contain each circuit, where each component label is
+ * used and the order to evaluate them in. A version itself only holds the
+ * component values and a snapshot of each distinct circuit, in persistent
+ * arrays. Copying a version forks it in constant time, and an edit makes new
+ * snapshots of only the circuits on the paths from the changed components up
+ * to the library, copying O(log N) array nodes for each and sharing
+ * everything else. Versions never change once they are made, so any number
+ * of them can be evaluated at once
+ *  Implementation:  libraryversion.cpp
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef LIBRARYVERSION_H
+#define LIBRARYVERSION_H
+
+#include <memory> // shared_ptr
+#include <string> // labels
+#include <vector> // vector container
+
+#include "complex.h"         // complex class
+#include "persistentarray.h" // arrays shared between versions
+#include "snapshot.h"        // immutable circuits
+
+// circuits and labels shared by every version taken from the same libraries
+struct VersionLayout;
+
+class LibraryVersion {
+private:
+  shared_ptr<const VersionLayout> layout;
+  PersistentArray<ComponentSnapshot> components; // component library
+  PersistentArray<SnapshotPtr> nodes; // distinct circuits in evaluation order
+
+  // version with these contents (layout, components, circuits)
+  LibraryVersion(shared_ptr<const VersionLayout>,
+                 PersistentArray<ComponentSnapshot>,
+                 PersistentArray<SnapshotPtr>);
+
+public:
+  // version of the current libraries. Circuits shared in the library are
+  // shared in the version
+  static LibraryVersion take();
+
+  // version with a new value for every component with a label, in the
+  // component library and in every circuit. Throws 6 if there is no
+  // component with the label (label, value)
+  LibraryVersion with_value(const string &, const double &) const;
+
+  size_t get_no_components() const { return components.size(); }
+  const ComponentSnapshot &get_component(const size_t &i) const {
+    return components[i];
+  }
+  size_t get_no_circuits() const;
+  // circuit in library order (position)
+  SnapshotPtr get_circuit(const size_t &) const;
+
+  // impedance of every circuit at a frequency in library order, evaluating
+  // each distinct circuit once, with no side effects (frequency)
+  vector<Complex> impedances_at(const double &) const;
+};
+
+#endif
@@ -4,39 +4,76 @@
  *  Date:            29/03/17
  */
 
-#include <algorithm>        // sort
-#include <chrono>           // time for save file
-#include <ctime>            // date for save file
+#include <cmath>            // pow, sqrt
 #include <fstream>          // file io
 #include <initializer_list> // initializer_list for unknown numbers of params
-#include <iomanip>          // put_time
 #include <iostream>         // std io
 #include <limits>           // streamsize
+#include <memory>           // shared snapshots
+#include <sstream>          // istringstream to split commands
 #include <type_traits>      // is_same - function templates
 #include <vector>           // vector container
 
-#include "capacitor.h" // capacitor class
-#include "circuit.h"   // circuit class
-#include "component.h" // component base class
-#include "inductor.h"  // inductor class
-#include "main.h"      // functions and libs namespace
-#include "resistor.h"  // resistor class
+#include "binaryproject.h"  // binary project files
+#include "capacitor.h"      // capacitor class
+#include "circuit.h"        // circuit class
+#include "component.h"      // component base class
+#include "evaluator.h"      // parallel evaluation of the circuit library
+#include "inductor.h"       // inductor class
+#include "library.h"        // libs namespace and label registry
+#include "libraryversion.h" // forked libraries
+#include "main.h"           // functions and libs namespace
+#include "montecarlo.h"     // tolerance analysis
+#include "netlist.h"        // nodal analysis
+#include "optimiser.h"      // simplified circuits
+#include "project.h"        // text project files
+#include "renderer.h"       // buffered output
+#include "resistor.h"       // resistor class
+#include "sensitivity.h"    // derivatives of impedances
+#include "snapshot.h"       // immutable circuits
+#include "stats.h"          // performance counters
+#include "sweep.h"          // frequency sweeps
+#include "sweepexport.h"    // sweeps of the whole library
+#include "threadpool.h"     // shared thread pool
+#include "transient.h"      // time domain simulation
 
 using namespace std;
 
 //-----------------------------------------------------------------------------
 //---main function
 //-----------------------------------------------------------------------------
-int main() {
-  cout << "AC Circuit Manipulator\n"
-       << "  Author: Dónal Murray\n\n";
-  // call main menu function
-  main_menu();
+int main(int argc, char *argv[]) {
+  int status{0};
+  int arg{1};
+  string stats_filename;
+  if ((argc > arg + 1) && (string(argv[arg]) == "--stats")) {
+    // collect performance counters and write them to a file on exit
+    stats_filename = argv[arg + 1];
+    stats::enable(true);
+    arg += 2;
+  }
+  if ((argc > arg) && (string(argv[arg]) == "--batch")) {
+    // run a command file, or standard input if there is no file or it is -
+    status = run_batch(argc > arg + 1 ? argv[arg + 1] : "-");
+  } else {
+    cout << "AC Circuit Manipulator\n"
+         << "  Author: Dónal Murray\n\n";
+    // call main menu function
+    main_menu();
+  }
   // free up memory and clear vectors
-  clean_up(libs::component_lib);
-  clean_up(libs::circuit_lib);
+  libs::clear();
+  if (!stats_filename.empty()) {
+    ofstream stats_file(stats_filename.c_str());
+    if (stats_file.good()) {
+      stats::write_json(stats_file);
+    } else {
+      error(3);
+      status = 1;
+    }
+  }
   // exit
-  return 0;
+  return status;
 }
 
 //-----------------------------------------------------------------------------
@@ -58,6 +95,12 @@ void error(const int &err) {
   case 4:
     cerr << "invalid save file.\n";
     break;
+  case 5:
+    cerr << "network could not be solved.\n";
+    break;
+  case 6:
+    cerr << "no component or circuit with that label.\n";
+    break;
   default:
     cerr << "an error occurred.\n";
     break;
@@ -98,16 +141,6 @@ template <class T> T take_input(initializer_list<T> allowed) {
   return temp;
 }
 
-// template function to clean up memory at end of program
-template <class T> void clean_up(vector<T *> &lib) {
-  // iterate through lib vector and free up each element's memory
-  for (auto it = lib.begin(); it != lib.end(); it++) {
-    delete *it;
-  }
-  // clear the vector to give a vector of size 0
-  lib.clear();
-}
-
 //------------------------------------------------------------------------------
 //---function for UI
 //------------------------------------------------------------------------------
@@ -117,7 +150,6 @@ void main_menu() {
   string print_choice;   // user inputs which circuit to print
   bool quit_main{false}; // for exiting main menu
   bool quit_add{false};  // for exiting add menu
-  bool valid_print;      // to tell if a circuit exists or not
   while (!quit_main) {
     // draw menu
     cout << "\nSelect an option:\n"
@@ -129,11 +161,16 @@ void main_menu() {
          << "6     Print a circuit\n"
          << "7     Save project to file\n"
          << "8     Load a project from file\n"
+         << "9     Frequency sweep of a circuit\n"
+         << "10    Check a circuit with nodal analysis\n"
+         << "11    Write a report of the project to file\n"
+         << "12    Export a frequency sweep of every circuit to file\n"
+         << "13    Show performance counters\n"
          << "0     Quit\n"
          << endl
          << "Option: ";
     // take input with allowed values
-    main_choice = take_input({0, 1, 2, 3, 4, 5, 6, 7, 8});
+    main_choice = take_input({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13});
     switch (main_choice) {
     case 0:
       // user wants to exit
@@ -190,22 +227,16 @@ void main_menu() {
       print_circuit_lib(); // print the library for reference
       cout << "Select a circuit to print using its label: ";
       cin >> print_choice; // string so never fails
-      valid_print = false;
       try {
-        // iterate through circuit library to check it exists
-        for (auto it : libs::circuit_lib) {
-          if (it->get_label() == print_choice) {
-            // print_choice is a valid circuit
-            valid_print = true;
-            it->print_circuit(); // print it
-            // clear rest of stream in case there is anything else there
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-          }
-        }
-        if (!valid_print) {
+        // look the circuit up to check it exists
+        Circuit *circ{libs::find_circuit(print_choice)};
+        if (circ == nullptr) {
           // circuit does not exist
           throw(2);
         }
+        circ->print_circuit(); // print it
+        // clear rest of stream in case there is anything else there
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
       } catch (int &err) {
         error(err);
       }
@@ -226,6 +257,42 @@ void main_menu() {
         error(err);
       }
       break;
+    case 9:
+      // sweep a circuit over a range of frequencies
+      try {
+        sweep_circuit();
+      } catch (int &err) {
+        error(err);
+      }
+      break;
+    case 10:
+      // compare a circuit with the nodal analysis of its network
+      try {
+        check_circuit();
+      } catch (int &err) {
+        error(err);
+      }
+      break;
+    case 11:
+      // render everything to a file
+      try {
+        report_to_file();
+      } catch (int &err) {
+        error(err);
+      }
+      break;
+    case 12:
+      // sweep every circuit and stream the results to a file
+      try {
+        export_sweep_to_file();
+      } catch (int &err) {
+        error(err);
+      }
+      break;
+    case 13:
+      // show the counters and switch collection on or off
+      show_stats();
+      break;
     }
   }
 }
@@ -249,7 +316,7 @@ template <class T> void add_component() {
   }
   cin >> temp_val;
   // libs only used once in this function => just use binary scope operator
-  libs::component_lib.push_back(new T{temp_val});
+  libs::insert(libs::make<T>(temp_val));
 }
 
 // function to create a circuit - type - series or parallel
@@ -268,12 +335,11 @@ template <class T> void add_circuit() {
          << "Hz created\n\n";
   }
   // create circuit of specified type and frequency
-  circuit_lib.push_back(new T{freq_add});
+  Circuit *this_circuit{make<T>(freq_add)};
+  insert(this_circuit);
   // print libraries for reference
   print_component_lib();
   print_circuit_lib();
-  // define random access iterator to access current circuit
-  auto this_circuit = circuit_lib.end() - 1;
   // ask user to input components and circuits to add
   bool quit_create{false}; // loop while false
   string s_comp_to_add;    // user choice of component to add
@@ -286,34 +352,25 @@ template <class T> void add_circuit() {
       if (s_comp_to_add[0] == 'q') {
         // user wants to quit
         // print the circuit they just created
-        (*this_circuit)->print_circuit();
+        this_circuit->print_circuit();
         // go back to previous menu
         quit_create = true;
-      } else {
-        // iterate through component list to see if the label is a component
-        bool found{false};
-        for (auto it : component_lib) {
-          if (it->get_label() == s_comp_to_add) {
-            // add this component to the circuit
-            (*this_circuit)->add_component(it);
-            found = true;
-          }
-        }
-        // iterate through circuit list to see if the label is a circuit
-        for (auto it : circuit_lib) {
-          if (it->get_label() == s_comp_to_add) {
-            // add this subcircuit to the circuit
-            (*this_circuit)->add_subcircuit(it);
-            // change the subcircuit's freq to match this circuit
-            it->set_frequency((*this_circuit)->get_frequency());
-            cout << "Frequency of subcircuit changed to match the new "
-                    "circuit.\n";
-            found = true;
-          }
-        }
-        if (!found) {
-          throw(3);
+      } else if (Component *comp = find_component(s_comp_to_add)) {
+        // the label is a component, add it to the circuit
+        this_circuit->add_component(comp);
+      } else if (Circuit *circ = find_circuit(s_comp_to_add)) {
+        // the label is a circuit, add this subcircuit to the circuit
+        if (circ->contains(this_circuit)) {
+          // a circuit inside itself would never finish evaluating
+          throw(1);
         }
+        this_circuit->add_subcircuit(circ);
+        // change the subcircuit's freq to match this circuit
+        circ->set_frequency(this_circuit->get_frequency());
+        cout << "Frequency of subcircuit changed to match the new "
+                "circuit.\n";
+      } else {
+        throw(3);
       }
     } catch (int &err) {
       error(err);
@@ -327,59 +384,259 @@ template <class T> void add_circuit() {
 // function to iterate through component library and and print the
 // components
 void print_component_lib() {
+  Renderer out(cout);
+  print_component_lib(out);
+}
+
+// render the component library (renderer)
+void print_component_lib(Renderer &out) {
   using namespace libs; // libs used many times
-  cout << "\n-------Component Library-------\n"
-       << "| ID  Type       Value        |\n"
-       << "-------------------------------\n";
+  out << "\n-------Component Library-------\n"
+      << "| ID  Type       Value        |\n"
+      << "-------------------------------\n";
   int i{0}; // to test for an empty library
-  // sort library by component label using lambda which returns a bool
-  sort(component_lib.begin(), component_lib.end(),
-       [](const Component *lhs, const Component *rhs) -> bool {
-         return (lhs->get_label() < rhs->get_label());
-       });
-  for (auto it = component_lib.begin(); it != component_lib.end(); it++) {
+  // the index is kept in label order, so the library is never sorted
+  for (auto &it : ordered_components()) {
     // print out each component's label, type and value
     i++; // to test for an empty library
-    cout << **it << endl;
+    out << *it.second << "\n";
   }
   if (i < 1) {
-    cout << "Empty.\n";
+    out << "Empty.\n";
   }
-  cout << endl;
+  out << "\n";
 }
 
 // function to iterate through circuit library and and print the components
 void print_circuit_lib() {
+  Renderer out(cout);
+  print_circuit_lib(out);
+}
+
+// render the circuit library (renderer)
+void print_circuit_lib(Renderer &out) {
   using namespace libs;
-  cout << "\n--------Circuit Library-------------------\n"
-       << "| ID  Freq  Impedence  Component list     |\n"
-       << "------------------------------------------\n";
+  stats::ScopedTimer timer{stats::print_circuit_lib};
+  out << "\n--------Circuit Library-------------------\n"
+      << "| ID  Freq  Impedence  Component list     |\n"
+      << "------------------------------------------\n";
+  // evaluate the whole library up front so printing only reads the cache
+  evaluate_library(circuit_lib);
   int i{0}; // to test for an empty library
   for (auto it = circuit_lib.begin(); it != circuit_lib.end(); it++) {
     // print out each circuit's label, freq, impedence and components
     if ((*it)->get_no_components() == 0) {
     } else {
       i++; // to test for an empty library
-      cout << **it << endl;
+      out << **it << "\n";
     }
   }
   if (i < 1) {
-    cout << "Empty.\n";
+    out << "Empty.\n";
+  }
+  out << "\n";
+}
+
+// render both libraries and a drawing of every circuit (renderer)
+void print_report(Renderer &out) {
+  print_component_lib(out);
+  print_circuit_lib(out);
+  for (auto it : libs::circuit_lib) {
+    if (it->get_no_components() > 0) {
+      it->print_circuit(out);
+    }
+  }
+}
+
+// function to write the report for the whole project to a file
+void report_to_file() {
+  cout << "\nEnter a filename to write the report to: ";
+  string user_filename;
+  cin >> user_filename;
+  ofstream report_file(user_filename.c_str());
+  if (!report_file.good()) {
+    throw(3);
+  }
+  {
+    Renderer out(report_file);
+    print_report(out);
+  }
+  cout << "Report written to " << user_filename << ".\n";
+}
+
+//-----------------------------------------------------------------------------
+//---functions for frequency sweeps
+//-----------------------------------------------------------------------------
+// function to print the impedance of a circuit at logarithmically spaced
+// frequencies
+void sweep_circuit() {
+  print_circuit_lib(); // print the library for reference
+  cout << "Select a circuit to sweep using its label: ";
+  string sweep_choice;
+  cin >> sweep_choice;
+  Circuit *circ{libs::find_circuit(sweep_choice)};
+  if (circ == nullptr) {
+    // circuit does not exist
+    throw(2);
+  }
+  cout << "Enter the start frequency in Hz: ";
+  double start{take_input<double>({})};
+  cout << "Enter the end frequency in Hz: ";
+  double end{take_input<double>({})};
+  cout << "Enter the number of points: ";
+  int points{take_input<int>({})};
+  vector<double> freq{log_spaced_frequencies(start, end, points)};
+  vector<double> re;
+  vector<double> im;
+  Sweep(*circ).evaluate(freq, re, im);
+
+  cout << "\nFrequency sweep of circuit " << circ->get_label() << "\n"
+       << "  Freq/Hz  Z/\u03A9  |Z|/\u03A9\n";
+  for (int i{0}; i < points; i++) {
+    Complex z{re[i], im[i]};
+    cout << "  " << freq[i] << "  " << z << "  " << z.modulus() << "\n";
   }
   cout << endl;
 }
 
+// function to solve a circuit as a netlist and compare the impedance with the
+// series/parallel calculation
+void check_circuit() {
+  print_circuit_lib(); // print the library for reference
+  cout << "Select a circuit to check using its label: ";
+  string check_choice;
+  cin >> check_choice;
+  Circuit *circ{libs::find_circuit(check_choice)};
+  if (circ == nullptr) {
+    // circuit does not exist
+    throw(2);
+  }
+  Netlist net{*circ};
+  NodalAnalysis analysis{net, 1, 0};
+  Complex z{circ->get_impedance()};
+  Complex z_net{analysis.get_impedance(circ->get_frequency())};
+  cout << "\nCircuit " << circ->get_label() << " at "
+       << circ->get_frequency() << "Hz\n"
+       << "  series/parallel  Z=" << z << "\n"
+       << "  nodal analysis   Z=" << z_net << "  (" << net.get_no_nodes()
+       << " nodes, " << net.get_branches().size() << " branches)\n"
+       << "  relative difference " << (z - z_net).modulus() / z.modulus()
+       << "\n";
+  // also check where the first inductor and capacitor resonate, where their
+  // admittances cancel out in the matrix
+  const Component *inductor{nullptr};
+  const Component *capacitor{nullptr};
+  for (auto &it : net.get_branches()) {
+    const component_kind kind{it.component->get_kind()};
+    if ((kind == component_kind::inductor) && (inductor == nullptr)) {
+      inductor = it.component;
+    } else if ((kind == component_kind::capacitor) && (capacitor == nullptr)) {
+      capacitor = it.component;
+    }
+  }
+  if ((inductor != nullptr) && (capacitor != nullptr) &&
+      (inductor->get_value() > 0) && (capacitor->get_value() > 0)) {
+    // values are in microhenries and microfarads
+    const double resonance{1e6 / (2 * M_PI *
+                                  sqrt(inductor->get_value() *
+                                       capacitor->get_value()))};
+    vector<double> re;
+    vector<double> im;
+    Sweep(*circ).evaluate(vector<double>{resonance}, re, im);
+    const Complex z_res{re[0], im[0]};
+    const Complex z_net_res{analysis.get_impedance(resonance)};
+    cout << "At resonance of " << inductor->get_label() << " and "
+         << capacitor->get_label() << ", " << resonance << "Hz\n"
+         << "  series/parallel  Z=" << z_res << "\n"
+         << "  nodal analysis   Z=" << z_net_res << "\n"
+         << "  relative difference "
+         << (z_res - z_net_res).modulus() / z_res.modulus() << "\n";
+  }
+  cout << endl;
+}
+
+// function to write the impedance of every circuit at logarithmically
+// spaced frequencies to a CSV or binary file
+void export_sweep_to_file() {
+  cout << "\nEnter a filename to export to (.acs for a binary file): ";
+  string user_filename;
+  cin >> user_filename;
+  cout << "Enter the start frequency in Hz: ";
+  double start{take_input<double>({})};
+  cout << "Enter the end frequency in Hz: ";
+  double end{take_input<double>({})};
+  cout << "Enter the number of points: ";
+  int points{take_input<int>({})};
+  export_sweep(libs::circuit_lib, log_spaced_frequencies(start, end, points),
+               user_filename,
+               is_binary_sweep(user_filename) ? sweep_format::binary
+                                              : sweep_format::csv);
+  cout << "Sweep written to " << user_filename << ".\n";
+}
+
+//-----------------------------------------------------------------------------
+//---performance counters
+//-----------------------------------------------------------------------------
+// function to print the performance counters and switch collection on or off
+void show_stats() {
+  {
+    Renderer out(cout);
+    stats::print(out);
+  }
+  cout << "1     Switch collection " << (stats::enabled ? "off" : "on") << "\n"
+       << "2     Reset counters\n"
+       << "0     Back\n"
+       << "Option: ";
+  switch (take_input({0, 1, 2})) {
+  case 1:
+    stats::enable(!stats::enabled);
+    cout << "Collection switched " << (stats::enabled ? "on" : "off")
+         << ".\n";
+    break;
+  case 2:
+    stats::reset();
+    cout << "Counters reset.\n";
+    break;
+  }
+}
+
 //-----------------------------------------------------------------------------
 //---functions for load/save
 //-----------------------------------------------------------------------------
+namespace {
+// check whether a filename ends with an extension (filename, extension)
+bool has_extension(const string &filename, const string &extension) {
+  return (filename.length() > extension.length()) &&
+         (filename.compare(filename.length() - extension.length(),
+                           extension.length(), extension) == 0);
+}
+} // namespace
+
+// check whether a filename has the binary project extension
+bool is_binary_project(const string &filename) {
+  return has_extension(filename, ".acb");
+}
+
+// check whether a filename has the binary sweep extension
+bool is_binary_sweep(const string &filename) {
+  return has_extension(filename, ".acs");
+}
+
 // function to save components and circuits to file
 void save_project() {
   using namespace libs;
   // open file and check that it opened properly
-  cout << "\nEnter a filename to save to: ";
+  cout << "\nEnter a filename to save to (.acb for a binary project, which "
+          "loads without being parsed): ";
   string user_filename;
   cin >> user_filename;
 
+  if (is_binary_project(user_filename)) {
+    save_binary_project(user_filename, component_lib, circuit_lib);
+    cout << "Project saved succesfully";
+    return;
+  }
+
   // open file and make sure it opened correctly
   ofstream save_file(user_filename.c_str());
   if (!save_file.good()) {
@@ -390,26 +647,27 @@ void save_project() {
   }
 
   // save project
-  save_file << "#SaveFile ";
-  auto now = chrono::system_clock::now();
-  auto in_time_t = chrono::system_clock::to_time_t(now);
+  write_project(save_file, component_lib, circuit_lib);
 
-  save_file << put_time(localtime(&in_time_t), "%d-%m-%Y %X") << endl;
+  save_file.close();
+  cout << "Project saved succesfully";
+}
 
-  save_file << "[Components]\n";
-  for (auto it : component_lib) {
-    save_file << *it << endl;
+// function to load a binary project. The file is mapped rather than read and
+// parsed, but every component and circuit is still created from it before it
+// is unmapped. Circuits go into the library in the order they were saved in
+void load_binary_project(const string &filename, ostream &messages) {
+  using namespace libs;
+  stats::ScopedTimer timer{stats::load_project};
+  BinaryProject project(filename);
+  messages << filename << " opened successfully.\nLoading project...\n";
+  for (size_t i{0}; i < project.get_no_components(); i++) {
+    insert(project.get_component(i));
   }
-
-  save_file << "[Circuits]\n";
-  for (auto it : circuit_lib) {
-    save_file << *it << endl;
+  for (size_t i{0}; i < project.get_no_library_circuits(); i++) {
+    insert(project.get_circuit(project.get_library_circuit(i)));
   }
-
-  save_file << "[End]\n";
-
-  save_file.close();
-  cout << "Project saved succesfully";
+  messages << "Project loaded succesfully.\n\n";
 }
 
 // function to load a previous session
@@ -420,6 +678,11 @@ void load_project() {
   string user_filename;
   cin >> user_filename;
 
+  if (is_binary_project(user_filename)) {
+    load_binary_project(user_filename, cout);
+    return;
+  }
+
   ifstream load_file(user_filename.c_str());
   if (!load_file.good()) {
     throw(3);
@@ -427,106 +690,412 @@ void load_project() {
     cout << user_filename << " opened successfully.\n";
   }
 
-  // read project back out of the file using getline
-  string line; // current line of file
-  // define state machine:
-  //    0 initial state
-  //    1 read components
-  //    2 read circuits
-  //    3 exit
-  int state{0};
-  bool file_check{false}; // to check for invalid save files
-  while (getline(load_file, line)) {
-    if (!file_check) {
-      // first line, check if the file is actually a save file
-      if (line.substr(0, 9) != "#SaveFile") {
-        // not a valid save file
-        throw(4);
+  // read project back out of the file
+  read_project(load_file, cout, cerr);
+  // close file and let the user know that the operation was successful
+  load_file.close();
+  cout << "Project loaded succesfully.\n\n";
+}
+
+//-----------------------------------------------------------------------------
+//---batch mode
+//-----------------------------------------------------------------------------
+// run one command from a command file (command line)
+void run_command(const string &line) {
+  using namespace libs;
+  istringstream fields(line);
+  string command;
+  if (!(fields >> command) || (command[0] == '#')) {
+    // blank line or comment
+    return;
+  }
+  string kind;
+  string label;
+  double value;
+  if (command == "add") {
+    // add <resistor|capacitor|inductor> <value> [label]
+    // add <series|parallel> <frequency> [label starting with S or P]
+    if (!(fields >> kind >> value)) {
+      throw(1);
+    }
+    fields >> label;
+    if (!label.empty() &&
+        (((kind == "series") && !Circuit::is_valid_label(label, false)) ||
+         ((kind == "parallel") && !Circuit::is_valid_label(label, true)))) {
+      // checked before anything is created
+      throw(1);
+    }
+    Component *new_comp{nullptr};
+    Circuit *new_circ{nullptr};
+    if (kind == "resistor") {
+      new_comp = make<Resistor>(value);
+    } else if (kind == "capacitor") {
+      new_comp = make<Capacitor>(value);
+    } else if (kind == "inductor") {
+      new_comp = make<Inductor>(value);
+    } else if (kind == "series") {
+      new_circ = make<Series>(value);
+    } else if (kind == "parallel") {
+      new_circ = make<Parallel>(value);
+    } else {
+      throw(1);
+    }
+    // rename before registering, like loading a project
+    if (new_comp != nullptr) {
+      if (!label.empty()) {
+        new_comp->set_label(label);
+      }
+      insert(new_comp);
+    } else {
+      if (!label.empty()) {
+        new_circ->set_label(label);
+      }
+      insert(new_circ);
+    }
+  } else if (command == "connect") {
+    // connect <circuit> <labels of components/subcircuits>...
+    fields >> label;
+    Circuit *this_circuit{find_circuit(label)};
+    if (this_circuit == nullptr) {
+      throw(2);
+    }
+    while (fields >> label) {
+      if (Component *comp = find_component(label)) {
+        this_circuit->add_component(comp);
+      } else if (Circuit *circ = find_circuit(label)) {
+        if (circ->contains(this_circuit)) {
+          // a circuit inside itself would never finish evaluating
+          throw(1);
+        }
+        this_circuit->add_subcircuit(circ);
+        // change the subcircuit's freq to match this circuit
+        circ->set_frequency(this_circuit->get_frequency());
       } else {
-        // print the date and time of last save
-        cout << "Loading project...\nLast saved: " << line.substr(10) << endl;
+        throw(6);
       }
-      file_check = true;
-    } else if (line == "[Components]") {
-      // go to state 1: read in components
-      state++;
-    } else if (line == "[Circuits]") {
-      // go to state 2: read in circuits
-      state++;
-    } else if (line == "[End]") {
-      // go to state 3: do nothing til exit
-      state++;
-    } else if (state == 1) {
-      // check what type of component it is by first letter of label
-      switch (line[2]) {
-      case 'R':
-        // add a resistor with the correct value
-        component_lib.push_back(
-            new Resistor{stod(line.substr(16, line.length() - 17))});
-        break;
-      case 'C':
-        // add a capacitor with the correct value
-        component_lib.push_back(
-            new Capacitor{stod(line.substr(16, line.length() - 18))});
-        break;
-      case 'L':
-        // add an inductor with the correct value
-        component_lib.push_back(
-            new Inductor{stod(line.substr(16, line.length() - 18))});
-        break;
+    }
+  } else if (command == "evaluate") {
+    // evaluate [circuit labels]... - every circuit if there are none
+    vector<Circuit *> circuits;
+    while (fields >> label) {
+      Circuit *circ{find_circuit(label)};
+      if (circ == nullptr) {
+        throw(2);
+      }
+      circuits.push_back(circ);
+    }
+    if (circuits.empty()) {
+      circuits = circuit_lib;
+    }
+    vector<Complex> impedances{evaluate_library(circuits)};
+    for (size_t i{0}; i < circuits.size(); i++) {
+      cout << circuits[i]->get_label() << "  "
+           << circuits[i]->get_frequency() << "Hz  Z=" << impedances[i]
+           << "  |Z|=" << impedances[i].modulus() << "\n";
+    }
+  } else if (command == "evaluate_at") {
+    // evaluate_at <frequency>... - every circuit at each frequency, leaving
+    // the circuits' own frequencies alone
+    vector<double> freqs;
+    double freq;
+    while (fields >> freq) {
+      freqs.push_back(freq);
+    }
+    if (freqs.empty() || !fields.eof()) {
+      throw(1);
+    }
+    // the frequencies are evaluated concurrently on one snapshot
+    const shared_ptr<const LibrarySnapshot> snapshot{LibrarySnapshot::take()};
+    vector<vector<Complex>> impedances(freqs.size());
+    ThreadPool &pool{shared_pool()};
+    for (size_t i{0}; i < freqs.size(); i++) {
+      pool.submit(
+          [&, i]() { impedances[i] = snapshot->impedances_at(freqs[i]); });
+    }
+    pool.wait();
+    const vector<SnapshotPtr> &circuits{snapshot->get_circuits()};
+    for (size_t i{0}; i < freqs.size(); i++) {
+      for (size_t j{0}; j < circuits.size(); j++) {
+        cout << circuits[j]->get_label().str() << "  " << freqs[i]
+             << "Hz  Z=" << impedances[i][j]
+             << "  |Z|=" << impedances[i][j].modulus() << "\n";
       }
-      // set label to old label
-      (*(component_lib.end() - 1))->set_label(line.substr(2, 2));
-    } else if (state == 2) {
-      // find Hz position in the string to find the end of frequency
-      int hzpos;
-      hzpos = line.find("Hz");
-      // find position of brackets containing components
-      int bracpos_one{(int)(line.find_first_of("("))};
-      int bracpos_two{(int)(line.find_first_of(")"))};
-      // calculate number of components
-      int component_count{(bracpos_two - 1 - bracpos_one) / 3};
-      // check whether circuit is series of parallel
-      switch (line[2]) {
-      case 'S':
-        // add a series circuit with the correct freq
-        circuit_lib.push_back(new Series{stod(line.substr(6, hzpos - 5))});
-        break;
-      case 'P':
-        // add a parallel circuit with the correct freq
-        circuit_lib.push_back(new Parallel{stod(line.substr(6, hzpos - 5))});
-        break;
+    }
+  } else if (command == "variants") {
+    // variants <frequency> <component> <value>... - every circuit with the
+    // component given each value in turn, leaving the library alone
+    double freq;
+    string label;
+    vector<double> values;
+    double value;
+    if (!(fields >> freq >> label)) {
+      throw(1);
+    }
+    while (fields >> value) {
+      values.push_back(value);
+    }
+    if (values.empty() || !fields.eof()) {
+      throw(1);
+    }
+    // each variant is forked from one version and evaluated concurrently
+    const LibraryVersion base{LibraryVersion::take()};
+    vector<LibraryVersion> variants;
+    variants.reserve(values.size());
+    for (auto it : values) {
+      variants.push_back(base.with_value(label, it));
+    }
+    vector<vector<Complex>> impedances(variants.size());
+    ThreadPool &pool{shared_pool()};
+    for (size_t i{0}; i < variants.size(); i++) {
+      pool.submit(
+          [&, i]() { impedances[i] = variants[i].impedances_at(freq); });
+    }
+    pool.wait();
+    for (size_t i{0}; i < variants.size(); i++) {
+      for (size_t j{0}; j < base.get_no_circuits(); j++) {
+        cout << label << "=" << values[i] << "  "
+             << base.get_circuit(j)->get_label().str() << "  " << freq
+             << "Hz  Z=" << impedances[i][j]
+             << "  |Z|=" << impedances[i][j].modulus() << "\n";
       }
-      // make iterator for the current circuit
-      auto this_circuit{circuit_lib.end() - 1};
-      // set the label to the one from the file
-      (*this_circuit)->set_label(line.substr(2, 2));
-      string s_comp_to_add; // substrings of component/circuit labels to add
-      for (int i{0}; i < component_count; i++) {
-        // get the next component name from list
-        s_comp_to_add = line.substr(bracpos_one + 2 + (i * 3), 2);
-        // iterate through component list to see if the label is a component
-        for (auto it : component_lib) {
-          if (it->get_label() == s_comp_to_add) {
-            // add this component to the circuit
-            (*this_circuit)->add_component(it);
-          }
-        }
-        // iterate through circuit list to see if the label is a circuit
-        for (auto it : circuit_lib) {
-          if (it->get_label() == s_comp_to_add) {
-            // add this subcircuit to the circuit
-            (*this_circuit)->add_subcircuit(it);
-            // change the subcircuit's freq to match this circuit
-            it->set_frequency((*this_circuit)->get_frequency());
-            cout << "Frequency of subcircuit changed to match the new "
-                    "circuit.\n";
-          }
+    }
+  } else if (command == "sensitivity") {
+    // sensitivity <circuit> - dZ/dvalue of every component in it
+    fields >> label;
+    Circuit *circ{find_circuit(label)};
+    if (circ == nullptr) {
+      throw(2);
+    }
+    for (auto &it : impedance_sensitivity(*circ)) {
+      cout << label << "  " << it.component->get_label()
+           << "  dZ/dvalue=" << it.derivative << "\n";
+    }
+  } else if (command == "montecarlo") {
+    // montecarlo <circuit> <samples> <uniform|normal> <tolerance %> [seed]
+    uint64_t samples;
+    double tolerance;
+    uint64_t seed{0};
+    if (!(fields >> label >> samples >> kind >> tolerance)) {
+      throw(1);
+    }
+    fields >> seed;
+    Circuit *circ{find_circuit(label)};
+    if (circ == nullptr) {
+      throw(2);
+    }
+    Tolerance tol{Tolerance::uniform, tolerance / 100};
+    if (kind == "normal") {
+      tol.shape = Tolerance::normal;
+    } else if (kind != "uniform") {
+      throw(1);
+    }
+    MonteCarloResult result{MonteCarlo{*circ, tol}.run(samples, seed)};
+    for (auto *dist : {&result.modulus, &result.phase}) {
+      cout << label << (dist == &result.modulus ? "  |Z|" : "  arg(Z)")
+           << "  mean=" << dist->get_mean() << "  sd=" << dist->get_std_dev()
+           << "  min=" << dist->get_min() << "  1%=" << dist->quantile(0.01)
+           << "  50%=" << dist->quantile(0.5)
+           << "  99%=" << dist->quantile(0.99) << "  max=" << dist->get_max();
+      if (dist->get_invalid() > 0) {
+        cout << "  not finite=" << dist->get_invalid();
+      }
+      cout << "\n";
+    }
+  } else if (command == "optimise") {
+    // optimise <circuit> - sizes before and after, and both impedances
+    fields >> label;
+    Circuit *circ{find_circuit(label)};
+    if (circ == nullptr) {
+      throw(2);
+    }
+    const OptimisedCircuit optimised{*circ};
+    const OptimisationReport &report{optimised.get_report()};
+    cout << label << "  circuits " << report.circuits_before << " -> "
+         << report.circuits_after << "  terms " << report.terms_before
+         << " -> " << report.terms_after << "  divisions "
+         << report.divisions_before << " -> " << report.divisions_after
+         << "  depth " << report.depth_before << " -> " << report.depth_after
+         << "\n"
+         << label << "  Z=" << circ->get_impedance()
+         << "  optimised Z=" << optimised.impedance(circ->get_frequency())
+         << "\n";
+  } else if (command == "transient") {
+    // transient <circuit> <step s> <steps> <trapezoidal|euler> <filename>
+    //   <step V | sine V Hz | pwl filename> - response of the circuit to a
+    //   voltage, written to the file as it is calculated
+    double step_size;
+    uint64_t steps;
+    string rule;
+    string filename;
+    string shape;
+    if (!(fields >> label >> step_size >> steps >> rule >> filename >> shape)) {
+      throw(1);
+    }
+    Circuit *circ{find_circuit(label)};
+    if (circ == nullptr) {
+      throw(2);
+    }
+    TransientAnalysis::method method{TransientAnalysis::trapezoidal};
+    if (rule == "euler") {
+      method = TransientAnalysis::backward_euler;
+    } else if (rule != "trapezoidal") {
+      throw(1);
+    }
+    Waveform applied{Waveform::step, 0, 0, {}, {}};
+    if (shape == "step") {
+      fields >> applied.amplitude;
+    } else if (shape == "sine") {
+      applied.kind = Waveform::sine;
+      fields >> applied.amplitude >> applied.frequency;
+    } else if (shape == "pwl") {
+      // file of "time voltage" lines with increasing times
+      string waveform_filename;
+      fields >> waveform_filename;
+      ifstream waveform_file(waveform_filename.c_str());
+      if (!waveform_file.good()) {
+        throw(3);
+      }
+      applied.kind = Waveform::piecewise_linear;
+      double t;
+      double v;
+      while (waveform_file >> t >> v) {
+        if (!applied.times.empty() && !(t > applied.times.back())) {
+          throw(1);
         }
+        applied.times.push_back(t);
+        applied.voltages.push_back(v);
       }
+      if (!waveform_file.eof()) {
+        throw(1);
+      }
+    } else {
+      throw(1);
+    }
+    if (fields.fail()) {
+      throw(1);
+    }
+    Netlist net{*circ};
+    TransientAnalysis analysis{net, 1, 0};
+    ofstream waveform_out(filename.c_str());
+    if (!waveform_out.good()) {
+      throw(3);
+    }
+    Renderer out(waveform_out);
+    analysis.run(applied, step_size, steps, method, out);
+  } else if (command == "export") {
+    // export <start Hz> <end Hz> <points> <filename> - sweep of every
+    // circuit, binary if the filename ends in .acs
+    double start;
+    double end;
+    int points;
+    string filename;
+    if (!(fields >> start >> end >> points >> filename)) {
+      throw(1);
+    }
+    export_sweep(circuit_lib, log_spaced_frequencies(start, end, points),
+                 filename,
+                 is_binary_sweep(filename) ? sweep_format::binary
+                                           : sweep_format::csv);
+  } else if (command == "stats") {
+    // stats [on|off|reset|json <filename>] - print the counters if there is
+    // no argument
+    string option;
+    if (!(fields >> option)) {
+      Renderer out(cout);
+      stats::print(out);
+    } else if ((option == "on") || (option == "off")) {
+      stats::enable(option == "on");
+    } else if (option == "reset") {
+      stats::reset();
+    } else if (option == "json") {
+      string filename;
+      if (!(fields >> filename)) {
+        throw(1);
+      }
+      if (filename == "-") {
+        stats::write_json(cout);
+        return;
+      }
+      ofstream stats_file(filename.c_str());
+      if (!stats_file.good()) {
+        throw(3);
+      }
+      stats::write_json(stats_file);
+    } else {
+      throw(1);
+    }
+  } else if (command == "report") {
+    // report [filename] - standard output if there is no file
+    string filename;
+    if (!(fields >> filename) || (filename == "-")) {
+      Renderer out(cout);
+      print_report(out);
+      return;
     }
+    ofstream report_file(filename.c_str());
+    if (!report_file.good()) {
+      throw(3);
+    }
+    Renderer out(report_file);
+    print_report(out);
+  } else if ((command == "save") || (command == "load")) {
+    // save/load <filename>
+    string filename;
+    if (!(fields >> filename)) {
+      throw(1);
+    }
+    if (command == "save") {
+      if (is_binary_project(filename)) {
+        save_binary_project(filename, component_lib, circuit_lib);
+        return;
+      }
+      ofstream save_file(filename.c_str());
+      if (!save_file.good()) {
+        throw(3);
+      }
+      write_project(save_file, component_lib, circuit_lib);
+    } else {
+      // progress messages are not wanted
+      ostream null_stream{nullptr};
+      if (is_binary_project(filename)) {
+        load_binary_project(filename, null_stream);
+        return;
+      }
+      ifstream load_file(filename.c_str());
+      if (!load_file.good()) {
+        throw(3);
+      }
+      read_project(load_file, null_stream, cerr);
+    }
+  } else {
+    throw(1);
   }
-  // close file and let the user know that the operation was successful
-  load_file.close();
-  cout << "Project loaded succesfully.\n\n";
+}
+
+// run a command file without the menu, stopping at the first error. Only the
+// results of evaluate commands are printed (filename, - for standard input).
+// Returns the exit status
+int run_batch(const string &filename) {
+  ifstream file;
+  if (filename != "-") {
+    file.open(filename.c_str());
+    if (!file.good()) {
+      error(3);
+      return 1;
+    }
+  }
+  istream &commands{filename == "-" ? cin : file};
+  string line;
+  int line_number{0};
+  while (getline(commands, line)) {
+    line_number++;
+    try {
+      run_command(line);
+    } catch (int &err) {
+      cerr << "Line " << line_number << ": ";
+      error(err);
+      return 1;
+    }
+  }
+  return 0;
 }
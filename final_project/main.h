@@ -1,6 +1,6 @@
 /* main.h: AC Circuit Manipulator main file header containing function
- * prototypes and the libs namespace for the libraries of components and
- * circuits
+ * prototypes. The libs namespace for the libraries of components and circuits
+ * is in library.h
  *
  *  Author:          Dónal Murray
  *  Date:            29/03/17
@@ -13,6 +13,8 @@
 
 #include "circuit.h"
 #include "component.h"
+#include "library.h"
+#include "renderer.h"
 
 //-----------------------------------------------------------------------------
 //---function prototypes
@@ -20,8 +22,6 @@
 //---housekeeping
 // exception handling
 void error(const int &);
-// template function to clean up memory at end of program
-template <class T> void clean_up(vector<T *> &);
 // template function to take input
 template <class T> T take_input(initializer_list<T>);
 
@@ -37,22 +37,45 @@ template <class T> void add_circuit();
 //---print functions
 // function to iterate through component library and and print the components
 void print_component_lib();
+// render the component library (renderer)
+void print_component_lib(Renderer &);
 // function to iterate through circuit library and and print the impedance of
 // each circuit
 void print_circuit_lib();
+// render the circuit library (renderer)
+void print_circuit_lib(Renderer &);
+// render both libraries and a drawing of every circuit (renderer)
+void print_report(Renderer &);
+// function to write the report for the whole project to a file
+void report_to_file();
+
+//---sweep
+// function to print the impedance of a circuit over a range of frequencies
+void sweep_circuit();
+// function to compare the impedance of a circuit with nodal analysis
+void check_circuit();
+// function to write a sweep of every circuit to a file
+void export_sweep_to_file();
+
+//---performance counters
+// function to print the counters and switch collection on or off
+void show_stats();
 
 //---load and save
+// check whether a filename is for a binary project (filename)
+bool is_binary_project(const string &);
+// check whether a filename is for a binary sweep export (filename)
+bool is_binary_sweep(const string &);
 void save_project();
 void load_project();
+// load a memory mapped binary project (filename, stream for progress
+// messages)
+void load_binary_project(const string &, ostream &);
 
-//-----------------------------------------------------------------------------
-//---libs namespace to allow access to libraries from any function
-//-----------------------------------------------------------------------------
-namespace libs {
-// create polymorphic vector of base class pointers for component library
-vector<Component *> component_lib;
-// create polymorphic vector of base class pointers for circuit library
-vector<Circuit *> circuit_lib;
-} // namespace libs
+//---batch mode
+// run one command from a command file (command line)
+void run_command(const string &);
+// run a command file without the menu (filename, - for standard input)
+int run_batch(const string &);
 
 #endif
@@ -0,0 +1,301 @@
+/* montecarlo.cpp
+ * Implementation of Monte Carlo tolerance analysis. The value of component j
+ * in sample s comes from the generator with counter (s, j) and the seed as its
+ * key, so every sample can be drawn independently on any thread, and a
+ * component used in several places has the same value everywhere in a sample
+ *  Interface:      montecarlo.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <algorithm>     // min, max
+#include <cmath>         // sqrt, log, cos, atan2
+#include <unordered_map> // index of each component
+#include <vector>        // vector container
+
+#define _USE_MATH_DEFINES // M_PI
+#include <math.h>         // M_PI
+
+#include "montecarlo.h" // interface
+
+#include "circuit.h"    // circuit class
+#include "component.h"  // component base class
+#include "stats.h"      // performance counters
+#include "sweep.h"      // compiled circuits
+#include "threadpool.h" // shared thread pool
+
+const size_t MonteCarlo::chunk_size; // define static data member
+
+namespace {
+// number of samples evaluated to choose the histogram ranges
+const uint64_t pilot_samples{4096};
+// most leaf values to keep for a block of samples (256kB)
+const size_t max_block_values{32768};
+
+// uniform number in (0, 1) from a random word (word)
+double to_unit(const uint32_t &word) { return (word + 0.5) / 4294967296.0; }
+
+// histogram range covering the pilot samples with half their spread again
+// either side (smallest, largest, bins)
+Distribution histogram_for(const double &low, const double &high,
+                           const size_t &bins) {
+  if (!isfinite(low) || !isfinite(high)) {
+    // no finite pilot samples to take the range from
+    throw(5);
+  }
+  double margin{(high - low) / 2};
+  if (!(margin > 0)) {
+    // no spread, e.g. every tolerance is zero
+    margin = 1e-6 * abs(low) + 1e-12;
+  }
+  return Distribution{low - margin, high + margin, bins};
+}
+} // namespace
+
+//------------------------------------------------------------------------------
+// Distribution
+
+// empty distribution (start and end of the histogram, number of bins)
+Distribution::Distribution(const double &start, const double &end,
+                           const size_t &no_bins)
+    : low{start}, bin_width{(end - start) / no_bins}, bins(no_bins), below{0},
+      above{0}, count{0}, invalid{0}, mean{0}, m2{0}, min{HUGE_VAL},
+      max{-HUGE_VAL} {}
+
+// add the samples of another distribution with the same histogram, combining
+// the moments as in Chan et al.
+void Distribution::merge(const Distribution &other) {
+  invalid += other.invalid;
+  if (other.count == 0) {
+    return;
+  }
+  const uint64_t total{count + other.count};
+  const double delta{other.mean - mean};
+  mean += delta * other.count / total;
+  m2 += other.m2 + delta * delta * count / total * other.count;
+  count = total;
+  min = std::min(min, other.min);
+  max = std::max(max, other.max);
+  below += other.below;
+  above += other.above;
+  for (size_t i{0}; i < bins.size(); i++) {
+    bins[i] += other.bins[i];
+  }
+}
+
+uint64_t Distribution::get_count() const { return count; }
+
+uint64_t Distribution::get_invalid() const { return invalid; }
+
+double Distribution::get_mean() const { return mean; }
+
+// sample standard deviation
+double Distribution::get_std_dev() const {
+  return count > 1 ? sqrt(m2 / (count - 1)) : 0;
+}
+
+double Distribution::get_min() const { return min; }
+
+double Distribution::get_max() const { return max; }
+
+// value below which this fraction of the samples fall, interpolating within a
+// bin. Samples outside the histogram are taken to lie between it and the
+// smallest or largest sample
+double Distribution::quantile(const double &fraction) const {
+  if (count == 0) {
+    return 0;
+  }
+  double target{fraction * count};
+  if (target <= below) {
+    return below > 0 ? min + (low - min) * target / below : low;
+  }
+  target -= below;
+  for (size_t i{0}; i < bins.size(); i++) {
+    if (target <= bins[i]) {
+      return low + bin_width * (i + target / bins[i]);
+    }
+    target -= bins[i];
+  }
+  const double high{get_high()};
+  return above > 0 ? high + (max - high) * std::min(target / above, 1.0)
+                   : high;
+}
+
+// fraction of the samples between two values, counting the bins they cut
+// through in proportion
+double Distribution::fraction_between(const double &lower,
+                                      const double &upper) const {
+  if (count == 0) {
+    return 0;
+  }
+  double inside{0};
+  for (size_t i{0}; i < bins.size(); i++) {
+    const double start{low + i * bin_width};
+    const double overlap{std::min(upper, start + bin_width) -
+                         std::max(lower, start)};
+    if (overlap > 0) {
+      inside += bins[i] * std::min(overlap / bin_width, 1.0);
+    }
+  }
+  if (lower <= min && upper >= low) {
+    inside += below;
+  }
+  if (upper >= max && lower <= get_high()) {
+    inside += above;
+  }
+  return inside / count;
+}
+
+const vector<uint64_t> &Distribution::get_bins() const { return bins; }
+
+double Distribution::get_low() const { return low; }
+
+double Distribution::get_high() const {
+  return low + bin_width * bins.size();
+}
+
+//------------------------------------------------------------------------------
+// MonteCarlo
+
+// compile the circuit and find each component it uses
+MonteCarlo::MonteCarlo(const Circuit &circ, const Tolerance &tolerance)
+    : sweep{circ}, frequency{circ.get_frequency()}, block_size{256} {
+  unordered_map<const Component *, size_t> index;
+  for (auto it : sweep.get_leaf_components()) {
+    auto entry = index.find(it);
+    if (entry == index.end()) {
+      entry = index.emplace(it, components.size()).first;
+      components.push_back(it);
+      nominal.push_back(it->get_value());
+      tolerances.push_back(tolerance);
+    }
+    leaf_component.push_back(entry->second);
+  }
+  while ((block_size > 8) &&
+         (block_size * leaf_component.size() > max_block_values)) {
+    block_size /= 2;
+  }
+}
+
+// change the tolerance of one component, if it is in the circuit
+void MonteCarlo::set_tolerance(const Component *comp,
+                               const Tolerance &tolerance) {
+  for (size_t j{0}; j < components.size(); j++) {
+    if (components[j] == comp) {
+      tolerances[j] = tolerance;
+    }
+  }
+}
+
+// number of different components in the circuit
+size_t MonteCarlo::get_no_components() const { return components.size(); }
+
+// draw the values of n samples starting at first, then evaluate them. Values
+// are drawn for each component and copied to each of its leaves
+void MonteCarlo::evaluate_block(const uint64_t &first, const size_t &n,
+                                const uint64_t &seed, double *comp_values,
+                                double *leaf_values, double *re, double *im,
+                                Sweep::Workspace &work) const {
+  const array<uint32_t, 2> key{(uint32_t)seed, (uint32_t)(seed >> 32)};
+  for (size_t j{0}; j < components.size(); j++) {
+    double *row{comp_values + j * block_size};
+    const double value{nominal[j]};
+    const Tolerance &tolerance{tolerances[j]};
+    if (tolerance.fraction == 0) {
+      for (size_t i{0}; i < n; i++) {
+        row[i] = value;
+      }
+      continue;
+    }
+    for (size_t i{0}; i < n; i++) {
+      const uint64_t sample{first + i};
+      const array<uint32_t, 4> words{philox4x32(
+          {(uint32_t)sample, (uint32_t)(sample >> 32), (uint32_t)j, 0}, key)};
+      double deviation;
+      if (tolerance.shape == Tolerance::uniform) {
+        deviation = 2 * to_unit(words[0]) - 1;
+      } else {
+        // Box-Muller transform, scaled so fraction is three standard
+        // deviations
+        deviation = sqrt(-2 * log(to_unit(words[0]))) *
+                    cos(2 * M_PI * to_unit(words[1])) / 3;
+      }
+      row[i] = value * (1 + tolerance.fraction * deviation);
+    }
+  }
+  for (size_t k{0}; k < leaf_component.size(); k++) {
+    const double *row{comp_values + leaf_component[k] * block_size};
+    copy(row, row + n, leaf_values + k * block_size);
+  }
+  sweep.evaluate_values(frequency, leaf_values, block_size, re, im, n, work);
+}
+
+// evaluate the samples in chunks on the shared pool. Each chunk has its own
+// buffers and distributions, which are merged in order at the end
+MonteCarloResult MonteCarlo::run(const uint64_t &samples, const uint64_t &seed,
+                                 const size_t &no_bins) const {
+  stats::ScopedTimer timer{stats::montecarlo};
+  // evaluate a range of samples, giving each to a function (first sample,
+  // number of samples, function of the real and imaginary parts)
+  auto evaluate_range = [this, &seed](const uint64_t &first,
+                                      const uint64_t &count, auto &&record) {
+    vector<double> comp_values(components.size() * block_size);
+    vector<double> leaf_values(leaf_component.size() * block_size);
+    vector<double> re(block_size);
+    vector<double> im(block_size);
+    Sweep::Workspace work{sweep};
+    for (uint64_t start{0}; start < count; start += block_size) {
+      const size_t n{(size_t)std::min<uint64_t>(block_size, count - start)};
+      evaluate_block(first + start, n, seed, comp_values.data(),
+                     leaf_values.data(), re.data(), im.data(), work);
+      for (size_t i{0}; i < n; i++) {
+        record(re[i], im[i]);
+      }
+    }
+  };
+
+  // pilot run for the histogram ranges
+  double modulus_low{HUGE_VAL};
+  double modulus_high{-HUGE_VAL};
+  double phase_low{HUGE_VAL};
+  double phase_high{-HUGE_VAL};
+  evaluate_range(0, std::min(samples, pilot_samples),
+                 [&](const double &re, const double &im) {
+                   const double modulus{sqrt(re * re + im * im)};
+                   const double phase{atan2(im, re) * 180 / M_PI};
+                   if (isfinite(modulus)) {
+                     modulus_low = std::min(modulus_low, modulus);
+                     modulus_high = std::max(modulus_high, modulus);
+                   }
+                   if (isfinite(phase)) {
+                     phase_low = std::min(phase_low, phase);
+                     phase_high = std::max(phase_high, phase);
+                   }
+                 });
+  const MonteCarloResult empty{
+      histogram_for(modulus_low, modulus_high, no_bins),
+      histogram_for(phase_low, phase_high, no_bins)};
+
+  const uint64_t no_chunks{(samples + chunk_size - 1) / chunk_size};
+  vector<MonteCarloResult> chunks(no_chunks, empty);
+  ThreadPool &pool{shared_pool()};
+  for (uint64_t c{0}; c < no_chunks; c++) {
+    pool.submit([&, c]() {
+      MonteCarloResult &result{chunks[c]};
+      const uint64_t first{c * chunk_size};
+      evaluate_range(first, std::min<uint64_t>(chunk_size, samples - first),
+                     [&result](const double &re, const double &im) {
+                       result.modulus.add(sqrt(re * re + im * im));
+                       result.phase.add(atan2(im, re) * 180 / M_PI);
+                     });
+    });
+  }
+  pool.wait();
+
+  MonteCarloResult total{empty};
+  for (auto &chunk : chunks) {
+    total.modulus.merge(chunk.modulus);
+    total.phase.merge(chunk.phase);
+  }
+  return total;
+}
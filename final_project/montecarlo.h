@@ -0,0 +1,167 @@
+/* montecarlo.h
+ * Interface for Monte Carlo tolerance analysis. Every component's value is
+ * varied within its tolerance and the distribution of |Z| and the phase of a
+ * circuit are built up over many samples. Samples are evaluated in blocks
+ * with the compiled program of a Sweep, in fixed size chunks on the shared
+ * thread pool. The random numbers come from a counter-based generator
+ * (Philox4x32-10) keyed by the seed and indexed by the sample and component,
+ * so a run gives the same results however many threads evaluate it. Results
+ * are accumulated into histograms and running moments instead of being kept,
+ * and nothing is allocated for each sample. The phase is atan2(Im Z, Re Z) in
+ * degrees. Samples which are not finite (e.g. a capacitor at 0Hz) are counted
+ * but left out of the summaries
+ *  Implementation:  montecarlo.cpp
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include <array>   // counter and key of the generator
+#include <cmath>   // isfinite
+#include <cstddef> // size_t
+#include <cstdint> // fixed width integers
+#include <vector>  // vector container
+
+#include "circuit.h"   // circuit class
+#include "component.h" // component base class
+#include "sweep.h"     // compiled circuits
+
+// Philox4x32-10 counter-based random number generator: four random 32-bit
+// words for each counter and key (counter, key)
+inline array<uint32_t, 4> philox4x32(array<uint32_t, 4> counter,
+                                     array<uint32_t, 2> key) {
+  for (int round{0}; round < 10; round++) {
+    const uint64_t product0{(uint64_t)0xD2511F53u * counter[0]};
+    const uint64_t product1{(uint64_t)0xCD9E8D57u * counter[2]};
+    counter = {(uint32_t)(product1 >> 32) ^ counter[1] ^ key[0],
+               (uint32_t)product1,
+               (uint32_t)(product0 >> 32) ^ counter[3] ^ key[1],
+               (uint32_t)product0};
+    key[0] += 0x9E3779B9u;
+    key[1] += 0xBB67AE85u;
+  }
+  return counter;
+}
+
+// how far a component's value can vary from its nominal value
+struct Tolerance {
+  enum distribution {
+    uniform, // anywhere within +/- fraction of the value
+    normal   // normally distributed, fraction is three standard deviations
+  };
+  distribution shape;
+  double fraction;
+};
+
+// streaming summary of a quantity: count, mean, variance, range and a
+// histogram over a fixed range with counts of the samples either side of it.
+// Samples which are not finite are only counted
+class Distribution {
+private:
+  double low;            // start of the histogram
+  double bin_width;      // width of each bin
+  vector<uint64_t> bins; // histogram
+  uint64_t below;        // samples below the histogram
+  uint64_t above;        // samples above the histogram
+  uint64_t count;        // number of finite samples
+  uint64_t invalid;      // number of samples which are not finite
+  double mean;           // running mean
+  double m2;             // running sum of squared differences from the mean
+  double min;            // smallest sample
+  double max;            // largest sample
+
+public:
+  // empty distribution (start and end of the histogram, number of bins)
+  Distribution(const double &, const double &, const size_t &);
+
+  // add a sample (sample)
+  void add(const double &x) {
+    if (!isfinite(x)) {
+      invalid++;
+      return;
+    }
+    count++;
+    const double delta{x - mean};
+    mean += delta / count;
+    m2 += delta * (x - mean);
+    min = x < min ? x : min;
+    max = x > max ? x : max;
+    const double position{(x - low) / bin_width};
+    if (!(position >= 0)) {
+      below++;
+    } else if (position >= bins.size()) {
+      above++;
+    } else {
+      bins[(size_t)position]++;
+    }
+  }
+  // add the samples of another distribution with the same histogram
+  // (distribution)
+  void merge(const Distribution &);
+
+  uint64_t get_count() const;
+  uint64_t get_invalid() const;
+  double get_mean() const;
+  double get_std_dev() const;
+  double get_min() const;
+  double get_max() const;
+  // estimate of the value below which this fraction of the samples fall, from
+  // the histogram (fraction)
+  double quantile(const double &) const;
+  // estimate of the fraction of the samples between two values, e.g. the
+  // yield of a specification (lower limit, upper limit)
+  double fraction_between(const double &, const double &) const;
+  // histogram and its range
+  const vector<uint64_t> &get_bins() const;
+  double get_low() const;
+  double get_high() const;
+};
+
+// distributions of the magnitude and phase of the impedance
+struct MonteCarloResult {
+  Distribution modulus;
+  Distribution phase;
+};
+
+class MonteCarlo {
+private:
+  Sweep sweep;                          // compiled circuit
+  double frequency;                     // frequency of the circuit
+  vector<const Component *> components; // each component once
+  vector<size_t> leaf_component;        // component of each leaf of sweep
+  vector<double> nominal;               // nominal value of each component
+  vector<Tolerance> tolerances;         // tolerance of each component
+  // number of samples whose values are drawn and evaluated together, fewer
+  // for large circuits so that the values of a block stay in cache
+  size_t block_size;
+
+  // evaluate up to block_size samples without allocating (first sample,
+  // number of samples, seed, component values, leaf values, real parts,
+  // imaginary parts, workspace)
+  void evaluate_block(const uint64_t &, const size_t &, const uint64_t &,
+                      double *, double *, double *, double *,
+                      Sweep::Workspace &) const;
+
+public:
+  // number of samples in each task. It does not depend on the number of
+  // threads so that the results are always added up in the same order
+  static const size_t chunk_size{16384};
+
+  // analyse a circuit with every component given the same tolerance
+  // (circuit, tolerance)
+  MonteCarlo(const Circuit &, const Tolerance &);
+  // change the tolerance of one component (component, tolerance)
+  void set_tolerance(const Component *, const Tolerance &);
+  // number of different components in the circuit
+  size_t get_no_components() const;
+
+  // evaluate a number of samples (samples, seed, number of histogram bins).
+  // The histogram ranges come from a pilot run of the first few samples,
+  // which throws if none of them are finite
+  MonteCarloResult run(const uint64_t &, const uint64_t &,
+                       const size_t & = 100) const;
+};
+
+#endif
@@ -0,0 +1,213 @@
+/* netlist.cpp
+ * Implementation of the Netlist class to store networks of components and the
+ * NodalAnalysis class to solve them
+ *  Interface:      netlist.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <algorithm> // count_if
+#include <vector>    // vector container
+
+#include "netlist.h" // class interface
+
+#include "circuit.h"   // circuit class
+#include "complex.h"   // complex class
+#include "component.h" // component base class
+
+//-----------------------------------------------------------------------------
+//---Netlist
+//-----------------------------------------------------------------------------
+// default constructor
+Netlist::Netlist() : no_nodes{1} {}
+
+// build the network of a series/parallel circuit between node 1 and ground
+Netlist::Netlist(const Circuit &circ) : no_nodes{1} {
+  add_circuit(circ, add_node(), 0);
+}
+
+// add a node and return its number
+int Netlist::add_node() { return no_nodes++; }
+
+// connect a component between two nodes (node, node, component)
+void Netlist::add_branch(const int &from, const int &to, Component *comp) {
+  if ((from < 0) || (from >= no_nodes) || (to < 0) || (to >= no_nodes)) {
+    // node does not exist
+    throw(1);
+  }
+  branches.push_back(Branch{from, to, comp});
+}
+
+// number of nodes including ground
+int Netlist::get_no_nodes() const { return no_nodes; }
+
+// access the branches
+const vector<Netlist::Branch> &Netlist::get_branches() const {
+  return branches;
+}
+
+// add a series or parallel circuit between two nodes (circuit, node, node).
+// Subcircuits used more than once are added once for each use, as they are
+// separate copies in the real circuit
+void Netlist::add_circuit(const Circuit &circ, const int &a, const int &b) {
+  const vector<Component *> &comps{circ.get_components()};
+  const vector<Circuit *> &subs{circ.get_subcircuits()};
+  if (dynamic_cast<const Parallel *>(&circ) != nullptr) {
+    // everything is connected across the same two nodes
+    for (auto it : comps) {
+      add_branch(a, b, it);
+    }
+    for (auto it : subs) {
+      add_circuit(*it, a, b);
+    }
+    return;
+  }
+  // series circuits are a chain of nodes from a to b
+  const size_t count{comps.size() + subs.size()};
+  if (count == 0) {
+    // an empty series circuit is a short circuit, which has no admittance
+    throw(5);
+  }
+  int from{a};
+  for (size_t i{0}; i < count; i++) {
+    const int to{i + 1 == count ? b : add_node()};
+    if (i < comps.size()) {
+      add_branch(from, to, comps[i]);
+    } else {
+      add_circuit(*subs[i - comps.size()], from, to);
+    }
+    from = to;
+  }
+}
+
+//-----------------------------------------------------------------------------
+//---NodalAnalysis
+//-----------------------------------------------------------------------------
+// analyse a netlist for the impedance between two nodes (netlist, node,
+// reference node)
+NodalAnalysis::NodalAnalysis(const Netlist &net, const int &node,
+                             const int &reference)
+    : netlist{net}, port{node}, unknown{number_nodes(net, reference)},
+      no_unknowns{(int)count_if(unknown.begin(), unknown.end(),
+                                [](const int &i) { return i >= 0; })},
+      ldl{no_unknowns, pattern(net, unknown, true),
+          pattern(net, unknown, false)},
+      voltage(no_unknowns) {
+  if ((node < 0) || (node >= net.no_nodes) || (node == reference)) {
+    throw(1);
+  }
+  if (unknown[node] < 0) {
+    // no path between the nodes
+    throw(5);
+  }
+}
+
+// number the nodes connected to the reference node, leaving the reference
+// itself out (netlist, reference node)
+vector<int> NodalAnalysis::number_nodes(const Netlist &net,
+                                        const int &reference) {
+  const int n{net.no_nodes};
+  if ((reference < 0) || (reference >= n)) {
+    throw(1);
+  }
+  // branches at each node
+  vector<int> start(n + 1, 0);
+  for (auto &it : net.branches) {
+    start[it.from + 1]++;
+    start[it.to + 1]++;
+  }
+  for (int i{0}; i < n; i++) {
+    start[i + 1] += start[i];
+  }
+  vector<int> next(start.begin(), start.end() - 1);
+  vector<int> neighbour(start[n]);
+  for (auto &it : net.branches) {
+    neighbour[next[it.from]++] = it.to;
+    neighbour[next[it.to]++] = it.from;
+  }
+
+  // breadth first search out from the reference
+  vector<int> numbering(n, -1);
+  vector<bool> visited(n, false);
+  vector<int> queue{reference};
+  visited[reference] = true;
+  int count{0};
+  for (size_t q{0}; q < queue.size(); q++) {
+    const int i{queue[q]};
+    if (i != reference) {
+      numbering[i] = count++;
+    }
+    for (int p{start[i]}; p < start[i + 1]; p++) {
+      if (!visited[neighbour[p]]) {
+        visited[neighbour[p]] = true;
+        queue.push_back(neighbour[p]);
+      }
+    }
+  }
+  return numbering;
+}
+
+// rows or columns of the admittance matrix entries (netlist, numbering of the
+// nodes, rows). A branch adds its admittance to the diagonal at both ends and
+// subtracts it between them, leaving out anything at the reference
+vector<int> NodalAnalysis::pattern(const Netlist &net,
+                                   const vector<int> &numbering,
+                                   const bool &rows) {
+  vector<int> entries;
+  entries.reserve(3 * net.branches.size());
+  for (auto &it : net.branches) {
+    const int i{numbering[it.from]};
+    const int j{numbering[it.to]};
+    if (it.from == it.to) {
+      continue;
+    }
+    if (i >= 0) {
+      entries.push_back(i);
+    }
+    if (j >= 0) {
+      entries.push_back(j);
+    }
+    if ((i >= 0) && (j >= 0)) {
+      entries.push_back(rows ? i : j);
+    }
+  }
+  return entries;
+}
+
+// impedance between the two nodes (frequency)
+Complex NodalAnalysis::get_impedance(const double &freq) {
+  // admittances in the same order as the pattern
+  const Complex one{1, 0};
+  values.clear();
+  for (auto &it : netlist.branches) {
+    const int i{unknown[it.from]};
+    const int j{unknown[it.to]};
+    if (it.from == it.to) {
+      continue;
+    }
+    const Complex y{one / it.component->get_impedance(freq)};
+    if (i >= 0) {
+      values.push_back(y);
+    }
+    if (j >= 0) {
+      values.push_back(y);
+    }
+    if ((i >= 0) && (j >= 0)) {
+      values.push_back(Complex{0, 0} - y);
+    }
+  }
+  if (!ldl.factorise(values)) {
+    // singular admittance matrix
+    throw(5);
+  }
+  // drive 1A into the node, so the voltage is the impedance
+  for (auto &it : voltage) {
+    it = Complex{0, 0};
+  }
+  voltage[unknown[port]] = one;
+  ldl.solve(voltage.data());
+  return voltage[unknown[port]];
+}
+
+// number of entries in the factor
+int NodalAnalysis::get_fill() const { return ldl.get_fill(); }
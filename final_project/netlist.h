@@ -0,0 +1,93 @@
+/* netlist.h
+ * Interface for the Netlist class, which stores a circuit as nodes joined by
+ * components, and the NodalAnalysis class to solve one. Unlike series and
+ * parallel circuits a netlist can describe any network (bridges, meshes,
+ * ladders with cross links). Every component is a two terminal branch, so
+ * modified nodal analysis reduces to plain nodal analysis: the impedance
+ * between two nodes is the voltage across them when 1A is driven from one to
+ * the other, found from the admittance matrix Y V = I with the second node
+ * as the reference. Y is factorised with the sparse LDL^T in sparseldl.h
+ *  Implementation:  netlist.cpp
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef NETLIST_H
+#define NETLIST_H
+
+#include <vector> // vector container
+
+#include "circuit.h"   // circuit class
+#include "complex.h"   // complex class
+#include "component.h" // component base class
+#include "sparseldl.h" // sparse factorisation
+
+class Netlist {
+  friend class NodalAnalysis;
+
+public:
+  // component between two nodes
+  struct Branch {
+    int from;
+    int to;
+    Component *component;
+  };
+
+private:
+  int no_nodes;            // node 0 is ground
+  vector<Branch> branches; // components and where they are connected
+
+  // add a series or parallel circuit between two nodes (circuit, node, node)
+  void add_circuit(const Circuit &, const int &, const int &);
+
+public:
+  // default constructor - just the ground node
+  Netlist();
+  // build the network of a series/parallel circuit, which is connected
+  // between node 1 and ground (circuit)
+  Netlist(const Circuit &);
+
+  // add a node and return its number
+  int add_node();
+  // connect a component between two nodes (node, node, component)
+  void add_branch(const int &, const int &, Component *);
+
+  // number of nodes including ground
+  int get_no_nodes() const;
+  // access the branches
+  const vector<Branch> &get_branches() const;
+};
+
+class NodalAnalysis {
+  friend class TransientAnalysis;
+
+private:
+  const Netlist &netlist;
+  int port;                // node the current is driven into
+  vector<int> unknown;     // unknown of each node, -1 if it is not solved for
+  int no_unknowns;         // number of nodes solved for
+  SparseLDL<Complex> ldl;  // factorisation, analysed once for every frequency
+  vector<Complex> values;  // admittance matrix entries
+  vector<Complex> voltage; // node voltages
+
+  // number the nodes connected to the reference node, leaving the reference
+  // itself out (netlist, reference node)
+  static vector<int> number_nodes(const Netlist &, const int &);
+  // rows or columns of the admittance matrix entries (netlist, numbering of
+  // the nodes, rows)
+  static vector<int> pattern(const Netlist &, const vector<int> &,
+                             const bool &);
+
+public:
+  // analyse a netlist for the impedance between two nodes (netlist, node,
+  // reference node). Nodes not connected to the reference are left out, and
+  // the netlist must not change while the analysis is used
+  NodalAnalysis(const Netlist &, const int &, const int &);
+
+  // impedance between the two nodes (frequency)
+  Complex get_impedance(const double &);
+  // number of entries in the factor, for comparing orderings
+  int get_fill() const;
+};
+
+#endif
@@ -0,0 +1,280 @@
+/* optimiser.cpp
+ * Implementation of the OptimisedCircuit class. Circuits are optimised from
+ * the bottom up, so every subcircuit is already in its simplest form when its
+ * parent is optimised and one pass is enough
+ *  Interface:      optimiser.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <algorithm>     // max, sort
+#include <map>           // nodes by structure
+#include <tuple>         // structure of a node
+#include <unordered_map> // optimised circuits
+#include <vector>        // vector container
+
+#define _USE_MATH_DEFINES // M_PI
+#include <math.h>         // M_PI
+
+#include "optimiser.h" // class interface
+
+#include "circuit.h"   // circuit class
+#include "complex.h"   // complex class
+#include "component.h" // component base class
+
+namespace {
+// the terms of a node: constant, jw and 1/jw
+const uint8_t constant_term{1};
+const uint8_t jw_term{2};
+const uint8_t inverse_jw_term{4};
+
+// number of terms used by a node (bits)
+size_t count_terms(const uint8_t &used) {
+  return ((used & constant_term) != 0) + ((used & jw_term) != 0) +
+         ((used & inverse_jw_term) != 0);
+}
+} // namespace
+
+// optimise the circuit and measure it before and after
+OptimisedCircuit::OptimisedCircuit(const Circuit &circ) : report{} {
+  unordered_map<const Circuit *, size_t> depths;
+  report.depth_before = measure(&circ, depths);
+
+  unordered_map<const Circuit *, Part> parts;
+  map<NodeKey, uint32_t> structures;
+  root = optimise(&circ, parts, structures);
+
+  // nodes which were flattened into their parents are no longer needed.
+  // Keep the rest in the same order, so children stay before their parents
+  vector<bool> needed(nodes.size(), false);
+  if (!root.is_element) {
+    needed[root.node] = true;
+  }
+  for (size_t i{nodes.size()}; i-- > 0;) {
+    if (needed[i]) {
+      for (uint32_t k{0}; k < nodes[i].no_children; k++) {
+        needed[children[nodes[i].first_child + k]] = true;
+      }
+    }
+  }
+  vector<uint32_t> new_index(nodes.size());
+  vector<Node> kept_nodes;
+  vector<uint32_t> kept_children;
+  vector<size_t> node_depth;
+  for (size_t i{0}; i < nodes.size(); i++) {
+    if (!needed[i]) {
+      continue;
+    }
+    Node node{nodes[i]};
+    size_t depth{1};
+    node.first_child = kept_children.size();
+    for (uint32_t k{0}; k < nodes[i].no_children; k++) {
+      const uint32_t child{new_index[children[nodes[i].first_child + k]]};
+      kept_children.push_back(child);
+      depth = max(depth, node_depth[child] + 1);
+    }
+    new_index[i] = kept_nodes.size();
+    kept_nodes.push_back(node);
+    node_depth.push_back(depth);
+
+    report.terms_after += count_terms(node.used);
+    if (node.parallel) {
+      // one division per child and one for the whole node
+      report.divisions_after += node.no_children + 1;
+    }
+  }
+  nodes.swap(kept_nodes);
+  children.swap(kept_children);
+  report.circuits_after = nodes.size();
+  if (root.is_element) {
+    report.terms_after = 1;
+    report.divisions_after =
+        root.element.kind == component_kind::capacitor ? 1 : 0;
+  } else {
+    root.node = new_index[root.node];
+    report.depth_after = node_depth[root.node];
+  }
+}
+
+// count the circuits, components and divisions of a circuit and everything
+// below it, as they are evaluated with the cache. Returns the depth
+size_t OptimisedCircuit::measure(const Circuit *circ,
+                                 unordered_map<const Circuit *, size_t> &depths) {
+  auto found = depths.find(circ);
+  if (found != depths.end()) {
+    return found->second;
+  }
+  const bool parallel{dynamic_cast<const Parallel *>(circ) != nullptr};
+  report.circuits_before++;
+  report.terms_before += circ->get_components().size();
+  for (auto it : circ->get_components()) {
+    if (it->get_kind() == component_kind::capacitor) {
+      // Z = 1/jwC
+      report.divisions_before++;
+    }
+  }
+  if (parallel) {
+    report.divisions_before += circ->get_no_components() + 1;
+  }
+  size_t depth{1};
+  for (auto it : circ->get_subcircuits()) {
+    depth = max(depth, measure(it, depths) + 1);
+  }
+  depths[circ] = depth;
+  return depth;
+}
+
+// optimise a circuit once all of its subcircuits have been optimised
+OptimisedCircuit::Part
+OptimisedCircuit::optimise(const Circuit *circ,
+                           unordered_map<const Circuit *, Part> &parts,
+                           map<NodeKey, uint32_t> &structures) {
+  auto found = parts.find(circ);
+  if (found != parts.end()) {
+    // shared subcircuit
+    return found->second;
+  }
+  const bool parallel{dynamic_cast<const Parallel *>(circ) != nullptr};
+  Node node{parallel, 0, {0, 0, 0}, 0, 0};
+  vector<uint32_t> node_children;
+
+  // add a component to the terms of the node. In a series node the terms are
+  // R, L and 1/C, in a parallel node they are G, C and 1/L
+  auto add_element = [&node, &parallel](const Element &elem) {
+    switch (elem.kind) {
+    case component_kind::resistor:
+      node.used |= constant_term;
+      node.terms[0] += parallel ? 1 / elem.value : elem.value;
+      break;
+    case component_kind::capacitor:
+      if (parallel) {
+        node.used |= jw_term;
+        node.terms[1] += elem.value;
+      } else {
+        node.used |= inverse_jw_term;
+        node.terms[2] += 1 / elem.value;
+      }
+      break;
+    case component_kind::inductor:
+      if (parallel) {
+        node.used |= inverse_jw_term;
+        node.terms[2] += 1 / elem.value;
+      } else {
+        node.used |= jw_term;
+        node.terms[1] += elem.value;
+      }
+      break;
+    }
+  };
+
+  for (auto it : circ->get_components()) {
+    add_element(it->get_element());
+  }
+  for (auto it : circ->get_subcircuits()) {
+    const Part part{optimise(it, parts, structures)};
+    if (part.is_element) {
+      // subcircuit with a single term
+      add_element(part.element);
+      continue;
+    }
+    const Node &child{nodes[part.node]};
+    if ((child.parallel == parallel) &&
+        ((child.used != 0) || (child.no_children != 0))) {
+      // same kind as this circuit, flatten it into this node
+      node.used |= child.used;
+      for (int i{0}; i < 3; i++) {
+        node.terms[i] += child.terms[i];
+      }
+      for (uint32_t k{0}; k < child.no_children; k++) {
+        node_children.push_back(children[child.first_child + k]);
+      }
+    } else {
+      node_children.push_back(part.node);
+    }
+  }
+
+  Part result{false, {0, component_kind::resistor}, 0};
+  if (node_children.empty() && (count_terms(node.used) <= 1) &&
+      !(parallel && (node.used == 0))) {
+    // a single term, or an empty series circuit (Z = 0), is one component
+    result.is_element = true;
+    switch (node.used) {
+    case 0:
+    case constant_term:
+      result.element = {parallel ? 1 / node.terms[0] : node.terms[0],
+                        component_kind::resistor};
+      break;
+    case jw_term:
+      result.element = {node.terms[1], parallel ? component_kind::capacitor
+                                                : component_kind::inductor};
+      break;
+    case inverse_jw_term:
+      result.element = {1 / node.terms[2], parallel
+                                               ? component_kind::inductor
+                                               : component_kind::capacitor};
+      break;
+    }
+  } else if ((node_children.size() == 1) && (node.used == 0)) {
+    // a circuit with a single subcircuit has the same impedance
+    result.node = node_children[0];
+  } else {
+    // identical nodes are only stored once. The order of the children does
+    // not matter, so they are sorted
+    sort(node_children.begin(), node_children.end());
+    NodeKey key{parallel,       node.used,      node.terms[0],
+                node.terms[1], node.terms[2], node_children};
+    auto existing = structures.find(key);
+    if (existing != structures.end()) {
+      result.node = existing->second;
+    } else {
+      node.first_child = children.size();
+      node.no_children = node_children.size();
+      children.insert(children.end(), node_children.begin(),
+                      node_children.end());
+      result.node = nodes.size();
+      nodes.push_back(node);
+      structures.emplace(move(key), result.node);
+    }
+  }
+  parts[circ] = result;
+  return result;
+}
+
+// calculate the impedance at a frequency, evaluating every node once
+Complex OptimisedCircuit::impedance(const double &freq) const {
+  if (root.is_element) {
+    return element_impedance(root.element, freq);
+  }
+  const double x{2 * M_PI * freq / 1e6};
+  const Complex one{1, 0};
+  vector<Complex> values(nodes.size());
+  for (size_t i{0}; i < nodes.size(); i++) {
+    const Node &node{nodes[i]};
+    double imaginary{0};
+    if (node.used & jw_term) {
+      imaginary += node.terms[1] * x;
+    }
+    if (node.used & inverse_jw_term) {
+      imaginary -= node.terms[2] / x;
+    }
+    Complex total{node.terms[0], imaginary};
+    const uint32_t *child{children.data() + node.first_child};
+    if (node.parallel) {
+      for (uint32_t k{0}; k < node.no_children; k++) {
+        total = total + one / values[child[k]];
+      }
+      values[i] = one / total;
+    } else {
+      for (uint32_t k{0}; k < node.no_children; k++) {
+        total = total + values[child[k]];
+      }
+      values[i] = total;
+    }
+  }
+  return values[root.node];
+}
+
+// sizes before and after optimisation
+const OptimisationReport &OptimisedCircuit::get_report() const {
+  return report;
+}
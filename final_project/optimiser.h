@@ -0,0 +1,95 @@
+/* optimiser.h
+ * Interface for the OptimisedCircuit class, a simplified form of a circuit
+ * for evaluating its impedance. The library is not changed. Every node of the
+ * optimised form is a series or parallel combination of three frequency
+ * dependent terms and its children:
+ *    series    Z = R + jwL + 1/jwC (summed over its components) + sum Z_i
+ *    parallel  Y = G + jwC + 1/jwL (summed over its components) + sum 1/Z_i
+ * so all of the resistors, capacitors or inductors of a node are combined
+ * into one term, and a capacitor in parallel costs no division. Subcircuits
+ * of the same kind as their parent are flattened into it, subcircuits with a
+ * single term become one component of their parent, subcircuits with a single
+ * child are replaced by it, and structurally identical subcircuits are shared
+ * (hash-consing). Like a Sweep, the whole circuit is evaluated at one
+ * frequency. Sums are added up in a different order to the circuits, so the
+ * results agree to rounding error rather than exactly, and shorts or open
+ * circuits which give NaN when the circuit is evaluated may give a value here
+ *  Implementation:  optimiser.cpp
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef OPTIMISER_H
+#define OPTIMISER_H
+
+#include <cstddef>       // size_t
+#include <cstdint>       // fixed width integers
+#include <map>           // nodes by structure
+#include <tuple>         // structure of a node
+#include <unordered_map> // optimised circuits
+#include <vector>        // vector container
+
+#include "circuit.h"   // circuit class
+#include "complex.h"   // complex class
+#include "component.h" // component base class
+
+// size of a circuit before and after optimisation
+struct OptimisationReport {
+  size_t circuits_before;  // distinct circuits
+  size_t circuits_after;   // distinct nodes
+  size_t terms_before;     // components in the distinct circuits
+  size_t terms_after;      // combined terms of the nodes, which may repeat
+                           // the terms of a shared subcircuit flattened
+                           // into several parents
+  size_t divisions_before; // complex divisions for one evaluation
+  size_t divisions_after;
+  size_t depth_before; // most circuits from the top to a component
+  size_t depth_after;
+};
+
+class OptimisedCircuit {
+private:
+  // node of the optimised form. The terms are R, L and 1/C for series nodes
+  // and G, C and 1/L for parallel nodes
+  struct Node {
+    bool parallel;        // series or parallel
+    uint8_t used;         // bit i set if term i is used
+    double terms[3];      // constant, jw and 1/jw coefficients
+    uint32_t first_child; // first child in children
+    uint32_t no_children; // number of children
+  };
+
+  // a circuit after optimisation, either one component or a node
+  struct Part {
+    bool is_element;
+    Element element;
+    uint32_t node;
+  };
+  // kind, terms used, terms and children of a node, to find identical nodes
+  typedef tuple<bool, uint8_t, double, double, double, vector<uint32_t>>
+      NodeKey;
+
+  vector<Node> nodes;        // children before their parents
+  vector<uint32_t> children; // children of every node
+  Part root;                 // the whole circuit
+  OptimisationReport report; // how much smaller it is than the circuit
+
+  // optimise a circuit and everything below it (circuit, circuits already
+  // optimised, nodes by structure)
+  Part optimise(const Circuit *, unordered_map<const Circuit *, Part> &,
+                map<NodeKey, uint32_t> &);
+  // count the circuits, components, divisions and depth of a circuit and
+  // everything below it, each circuit once (circuit, depth of each circuit)
+  size_t measure(const Circuit *, unordered_map<const Circuit *, size_t> &);
+
+public:
+  // optimise a circuit (circuit)
+  OptimisedCircuit(const Circuit &);
+
+  // calculate the impedance at a frequency (frequency)
+  Complex impedance(const double &) const;
+  // sizes before and after optimisation
+  const OptimisationReport &get_report() const;
+};
+
+#endif
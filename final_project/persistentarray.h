@@ -0,0 +1,95 @@
+/* persistentarray.h
+ * PersistentArray class template for an array whose copies share its memory.
+ * The elements are kept in a tree of reference counted nodes, 32 to a node:
+ * the leaves hold the elements and every other node holds up to 32 nodes of
+ * the level below. Copying an array copies one pointer, and changing an
+ * element of a copy first copies the nodes on the path from the root to the
+ * element, so every other copy keeps the values it had. A change copies
+ * O(log N) nodes of at most 32 entries, however long the array is. A copy
+ * which has not been changed can be read by any number of threads
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef PERSISTENTARRAY_H
+#define PERSISTENTARRAY_H
+
+#include <algorithm> // min
+#include <memory>    // shared_ptr
+#include <utility>   // move
+#include <vector>    // vector container
+
+using namespace std;
+
+template <class T> class PersistentArray {
+private:
+  static const size_t node_bits{5};
+  static const size_t node_size{size_t(1) << node_bits};
+
+  // node of the tree. Leaves use elements and every other node uses children
+  struct Node {
+    vector<shared_ptr<Node>> children;
+    vector<T> elements;
+  };
+
+  shared_ptr<Node> root; // shared with copies until one is changed
+  size_t length;
+  size_t shift; // bits of a position used below the root
+
+public:
+  // empty array
+  PersistentArray() : root{make_shared<Node>()}, length{0}, shift{0} {}
+  // array holding these elements (elements)
+  explicit PersistentArray(const vector<T> &elements)
+      : length{elements.size()}, shift{0} {
+    // build the leaves, then each level above until one node is left
+    vector<shared_ptr<Node>> level;
+    for (size_t start{0}; start < length; start += node_size) {
+      level.push_back(make_shared<Node>());
+      level.back()->elements.assign(
+          elements.begin() + start,
+          elements.begin() + min(length, start + node_size));
+    }
+    while (level.size() > 1) {
+      vector<shared_ptr<Node>> above;
+      for (size_t start{0}; start < level.size(); start += node_size) {
+        above.push_back(make_shared<Node>());
+        above.back()->children.assign(
+            level.begin() + start,
+            level.begin() + min(level.size(), start + node_size));
+      }
+      level = move(above);
+      shift += node_bits;
+    }
+    root = level.empty() ? make_shared<Node>() : level.front();
+  }
+
+  size_t size() const { return length; }
+
+  // read an element (position)
+  const T &operator[](const size_t &i) const {
+    const Node *node{root.get()};
+    for (size_t bits{shift}; bits > 0; bits -= node_bits) {
+      node = node->children[(i >> bits) & (node_size - 1)].get();
+    }
+    return node->elements[i & (node_size - 1)];
+  }
+
+  // change an element. Each node on the path to it is copied unless this
+  // array is the only one using it (position, value)
+  void set(const size_t &i, T value) {
+    shared_ptr<Node> *node{&root};
+    for (size_t bits{shift};; bits -= node_bits) {
+      if (node->use_count() != 1) {
+        *node = make_shared<Node>(**node);
+      }
+      if (bits == 0) {
+        break;
+      }
+      node = &(*node)->children[(i >> bits) & (node_size - 1)];
+    }
+    (*node)->elements[i & (node_size - 1)] = move(value);
+  }
+};
+
+#endif
@@ -0,0 +1,534 @@
+/* project.cpp
+ * Implementation of reading and writing projects in the text format
+ *  Interface:      project.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <algorithm>    // lower_bound, min, sort
+#include <cctype>       // isspace
+#include <charconv>     // from_chars
+#include <chrono>       // time for save file
+#include <cstring>      // memchr
+#include <ctime>        // date for save file
+#include <iomanip>      // put_time
+#include <iostream>     // streams
+#include <string>       // file contents
+#include <string_view>  // lines and fields
+#include <system_error> // errc
+#include <utility>      // pair
+#include <vector>       // vector container
+
+#include "project.h" // interface
+
+#include "capacitor.h"  // capacitor class
+#include "circuit.h"    // circuit class
+#include "component.h"  // component base class
+#include "evaluator.h"  // parallel evaluation of the circuit library
+#include "inductor.h"   // inductor class
+#include "label.h"      // numbered labels
+#include "library.h"    // libs namespace and label registry
+#include "renderer.h"   // buffered output
+#include "resistor.h"   // resistor class
+#include "stats.h"      // performance counters
+#include "threadpool.h" // shared thread pool
+
+namespace {
+// size of the line-aligned chunks of the file which are tokenized by each task
+const size_t chunk_size{1 << 20};
+// number of circuits whose contents are found by each task
+const size_t circuits_per_task{4096};
+// size of the blocks the stream is read in
+const size_t read_block{1 << 16};
+
+// a line of the [Components] section
+struct ComponentLine {
+  component_kind kind; // type of component
+  double value;        // resistance/capacitance/inductance
+  string_view label;   // label in the file
+};
+
+// a line of the [Circuits] section. The labels of its components and
+// subcircuits are kept together with those of every other circuit
+struct CircuitLine {
+  bool parallel;       // series or parallel
+  double frequency;    // frequency of the circuit
+  string_view label;   // label in the file
+  size_t first_child;  // position of its first child in the list of children
+  size_t no_children;  // number of components and subcircuits
+  size_t line;         // line number in the file
+};
+
+// splits text into lines and lines into fields separated by whitespace, in
+// one pass and without copying anything. Fields are views of the text, so
+// labels can be any length
+class Tokenizer {
+private:
+  const char *position; // start of the next line
+  const char *end;      // end of the text
+  const char *field;    // start of the next field in the current line
+  const char *line_end; // end of the current line
+  size_t line_number;   // line number of the current line in the file
+
+public:
+  // tokenize some text which starts on a line of the file (text, line number
+  // of the line before it)
+  Tokenizer(const string_view &text, const size_t &first_line)
+      : position{text.data()}, end{text.data() + text.length()},
+        field{position}, line_end{position}, line_number{first_line} {}
+
+  // move to the next line, returning false at the end of the text (line
+  // without its newline)
+  bool next_line(string_view &line) {
+    if (position == end) {
+      return false;
+    }
+    const char *newline{
+        static_cast<const char *>(memchr(position, '\n', end - position))};
+    line_end = (newline == nullptr) ? end : newline;
+    line = string_view{position, size_t(line_end - position)};
+    field = position;
+    position = (newline == nullptr) ? end : newline + 1;
+    line_number++;
+    return true;
+  }
+
+  // split the next field off the current line, like reading from an
+  // istringstream. Returns false if there are none left (field)
+  bool next_field(string_view &text) {
+    while ((field != line_end) && isspace((unsigned char)*field)) {
+      field++;
+    }
+    const char *start{field};
+    while ((field != line_end) && !isspace((unsigned char)*field)) {
+      field++;
+    }
+    text = string_view{start, size_t(field - start)};
+    return !text.empty();
+  }
+
+  size_t line() const { return line_number; }
+};
+
+// result of reading a line
+enum class line_status { read, skipped, invalid };
+
+// read the number at the start of a field, ignoring anything after it such as
+// its unit, like stod. Returns false if the field does not start with a number
+// (field, number)
+bool read_number(const string_view &text, double &number) {
+  const char *start{text.data()};
+  const char *end{start + text.length()};
+  // from_chars does not accept a plus sign
+  if ((end - start > 1) && (*start == '+') && (start[1] != '-')) {
+    start++;
+  }
+  return from_chars(start, end, number).ec == errc{};
+}
+
+// read a line of the [Components] section: label, type and value with its
+// unit. Lines with too few fields or an unknown type are skipped (tokenizer
+// on the line, line read, what is wrong with an invalid line)
+line_status parse_component(Tokenizer &tokens, ComponentLine &result,
+                            const char *&problem) {
+  string_view type;
+  string_view field;
+  if (!tokens.next_field(result.label) || !tokens.next_field(type) ||
+      !tokens.next_field(field)) {
+    return line_status::skipped;
+  }
+  if (type == "Resistor") {
+    result.kind = component_kind::resistor;
+  } else if (type == "Capacitor") {
+    result.kind = component_kind::capacitor;
+  } else if (type == "Inductor") {
+    result.kind = component_kind::inductor;
+  } else {
+    return line_status::skipped;
+  }
+  if (!read_number(field, result.value)) {
+    problem = "the value is not a number";
+    return line_status::invalid;
+  }
+  return line_status::read;
+}
+
+// read a line of the [Circuits] section: label, frequency with Hz, impedance
+// (recalculated so ignored), then the labels of its components and
+// subcircuits in brackets, which are added to the list of children. Lines
+// with too few fields are skipped (tokenizer on the line, line read, labels
+// of the children of every circuit, what is wrong with an invalid line)
+line_status parse_circuit(Tokenizer &tokens, CircuitLine &result,
+                          vector<string_view> &children,
+                          const char *&problem) {
+  string_view field;
+  string_view impedance;
+  result.line = tokens.line();
+  if (!tokens.next_field(result.label) || !tokens.next_field(field) ||
+      !tokens.next_field(impedance)) {
+    return line_status::skipped;
+  }
+  // check whether circuit is series or parallel
+  switch (result.label[0]) {
+  case 'S':
+    result.parallel = false;
+    break;
+  case 'P':
+    result.parallel = true;
+    break;
+  default:
+    problem = "a circuit label must start with S or P";
+    return line_status::invalid;
+  }
+  if (!read_number(field, result.frequency)) {
+    problem = "the frequency is not a number";
+    return line_status::invalid;
+  }
+  result.first_child = children.size();
+  tokens.next_field(field); // opening bracket
+  while (tokens.next_field(field) && (field != ")")) {
+    children.push_back(field);
+  }
+  result.no_children = children.size() - result.first_child;
+  return line_status::read;
+}
+
+// read the rest of a stream into a string (stream, string)
+void read_all(istream &is, string &text) {
+  char block[read_block];
+  while (is.read(block, read_block) || (is.gcount() > 0)) {
+    text.append(block, is.gcount());
+  }
+}
+
+// whether a line is one of the markers between the sections (line)
+bool is_marker(const string_view &line) {
+  return (line == "[Components]") || (line == "[Circuits]") ||
+         (line == "[End]");
+}
+
+// a line-aligned chunk of the file and what was read from it. The chunks are
+// tokenized in parallel, once to count their lines and markers and once to
+// read them, and then joined in order
+struct Chunk {
+  string_view text;                   // lines of the chunk
+  size_t no_lines;                    // number of lines
+  int no_markers;                     // number of section markers
+  int section;                        // section at the start of the chunk
+  size_t first_line;                  // line number of the line before it
+  vector<ComponentLine> components;   // component lines read
+  vector<CircuitLine> circuits;       // circuit lines read
+  vector<string_view> children;       // labels of the circuits' children
+  int invalid_section;                // section of a line which could not
+                                      // be read, 0 if there is none
+  size_t invalid_line;                // line number of that line
+  const char *problem;                // what is wrong with it
+};
+
+// count the lines and section markers of a chunk (chunk)
+void count_lines(Chunk &chunk) {
+  Tokenizer tokens{chunk.text, 0};
+  string_view this_line;
+  chunk.no_markers = 0;
+  while (tokens.next_line(this_line)) {
+    if (is_marker(this_line)) {
+      chunk.no_markers++;
+    }
+  }
+  chunk.no_lines = tokens.line();
+}
+
+// read the lines of a chunk, up to the end of the third section or the first
+// line which cannot be read (chunk)
+void read_chunk(Chunk &chunk) {
+  Tokenizer tokens{chunk.text, chunk.first_line};
+  string_view this_line;
+  int section{chunk.section};
+  while ((section < 3) && tokens.next_line(this_line)) {
+    if (is_marker(this_line)) {
+      section++;
+      continue;
+    }
+    line_status status{line_status::skipped};
+    if (section == 1) {
+      chunk.components.emplace_back();
+      status = parse_component(tokens, chunk.components.back(),
+                               chunk.problem);
+      if (status != line_status::read) {
+        chunk.components.pop_back();
+      }
+    } else if (section == 2) {
+      chunk.circuits.emplace_back();
+      status = parse_circuit(tokens, chunk.circuits.back(), chunk.children,
+                             chunk.problem);
+      if (status != line_status::read) {
+        chunk.circuits.pop_back();
+      }
+    }
+    if (status == line_status::invalid) {
+      chunk.invalid_section = section;
+      chunk.invalid_line = tokens.line();
+      return;
+    }
+  }
+}
+
+// label from the file, looked up as a number if it is one so that only other
+// labels are stored as text (text)
+Label file_label(const string_view &text) {
+  Label label{0, 0};
+  return Label::parse(text, label) ? label : Label{text};
+}
+} // namespace
+
+// write a project in the text format (stream, components, circuits)
+void write_project(ostream &os, const vector<Component *> &components,
+                   const vector<Circuit *> &circuits) {
+  stats::ScopedTimer timer{stats::save_project};
+  const streampos start{os.tellp()};
+  auto now = chrono::system_clock::now();
+  auto in_time_t = chrono::system_clock::to_time_t(now);
+  os << "#SaveFile " << put_time(localtime(&in_time_t), "%d-%m-%Y %X")
+     << "\n";
+
+  // everything else is formatted in large chunks
+  Renderer out(os);
+  out << "[Components]\n";
+  for (auto it : components) {
+    out << *it << "\n";
+  }
+
+  out << "[Circuits]\n";
+  // evaluate the whole library up front so saving only reads the cache
+  evaluate_library(circuits);
+  // subcircuits first, which connecting circuits in batch mode does not
+  // guarantee for the library, so that every label is read before it is used
+  for (auto it : Circuit::subcircuits_first(circuits)) {
+    out << *it << "\n";
+  }
+
+  out << "[End]\n";
+  out.flush();
+  if (start != streampos(-1)) {
+    stats::add(stats::bytes_saved, os.tellp() - start);
+  }
+}
+
+// read a project in the text format into the libraries (stream, stream for
+// progress messages, stream for errors). The file is read into one buffer
+// and split into line-aligned chunks, which are tokenized in parallel with
+// labels and numbers read in place. The line numbers of each chunk come from
+// the number of lines in the chunks before it. Everything is then created,
+// labelled, connected and registered in file order, exactly as if the file
+// had been read one line at a time. Reading stops at the first line which
+// cannot be read or which contains a label that is not defined above it,
+// after everything before it has been loaded, and the line is reported
+// before the error is thrown
+void read_project(istream &is, ostream &messages, ostream &errors) {
+  using namespace libs;
+  stats::ScopedTimer timer{stats::load_project};
+  string line; // first line of file
+  // first line, check if the file is actually a save file
+  if (!getline(is, line) || (line.substr(0, 9) != "#SaveFile")) {
+    // not a valid save file
+    errors << "Save file line 1: not a save file.\n";
+    throw(4);
+  }
+  // print the date and time of last save
+  messages << "Loading project...\nLast saved: "
+           << (line.length() > 10 ? line.substr(10) : "") << endl;
+  string text;
+  read_all(is, text);
+  stats::add(stats::bytes_loaded, line.length() + 1 + text.length());
+
+  // the rest of the file is split into sections at the first three markers.
+  // Lines before the first marker and after the third are ignored, as are
+  // component lines after the first line which cannot be read
+  vector<Chunk> chunks;
+  const string_view all_text{text};
+  for (size_t start{0}; start < all_text.length();) {
+    size_t end{all_text.find('\n', min(all_text.length(), start + chunk_size))};
+    end = (end == string_view::npos) ? all_text.length() : end + 1;
+    chunks.push_back(Chunk{all_text.substr(start, end - start), 0, 0, 0, 0,
+                           {}, {}, {}, 0, 0, nullptr});
+    start = end;
+  }
+  ThreadPool &pool{shared_pool()};
+  for (auto &it : chunks) {
+    pool.submit([&it]() { count_lines(it); });
+  }
+  pool.wait();
+  // the file's second line is the first line of the first chunk
+  size_t first_line{1};
+  int section{0};
+  for (auto &it : chunks) {
+    it.first_line = first_line;
+    it.section = section;
+    first_line += it.no_lines;
+    section = min(3, section + it.no_markers);
+  }
+  for (auto &it : chunks) {
+    if (it.section < 3) {
+      pool.submit([&it]() { read_chunk(it); });
+    }
+  }
+  pool.wait();
+
+  // join the chunks up to the first line which could not be read
+  vector<ComponentLine> component_lines;
+  vector<CircuitLine> circuit_lines;
+  vector<string_view> children;
+  const Chunk *invalid{nullptr}; // chunk with a line which could not be read
+  for (auto &it : chunks) {
+    component_lines.insert(component_lines.end(), it.components.begin(),
+                           it.components.end());
+    for (auto &circ_line : it.circuits) {
+      circ_line.first_child += children.size();
+    }
+    circuit_lines.insert(circuit_lines.end(), it.circuits.begin(),
+                         it.circuits.end());
+    children.insert(children.end(), it.children.begin(), it.children.end());
+    if (it.invalid_section != 0) {
+      invalid = &it;
+      break;
+    }
+  }
+  auto report_invalid = [&errors, &invalid]() {
+    errors << "Save file line " << invalid->invalid_line << ": "
+           << invalid->problem << ".\n";
+  };
+
+  // components
+  for (auto &it : component_lines) {
+    Component *new_comp{nullptr};
+    switch (it.kind) {
+    case component_kind::resistor:
+      new_comp = make<Resistor>(it.value);
+      break;
+    case component_kind::capacitor:
+      new_comp = make<Capacitor>(it.value);
+      break;
+    case component_kind::inductor:
+      new_comp = make<Inductor>(it.value);
+      break;
+    }
+    // set label to old label before registering it, so that the label it
+    // was given when it was created cannot hide another component
+    new_comp->set_label(file_label(it.label));
+    insert(new_comp);
+  }
+  if ((invalid != nullptr) && (invalid->invalid_section == 1)) {
+    // no circuits are read after a component which could not be
+    report_invalid();
+    throw(4);
+  }
+
+  // find what each circuit contains before anything is created. A child is a
+  // component, the latest circuit in the file with its label before its line
+  // or a circuit which was already in the library. The definitions of each
+  // label are sorted by label and then line to find the circuit in the file,
+  // and the registry is only read, so this can be done in parallel
+  const size_t no_circuits{circuit_lines.size()};
+  vector<pair<string_view, size_t>> definitions(no_circuits);
+  for (size_t i{0}; i < no_circuits; i++) {
+    definitions[i] = {circuit_lines[i].label, i};
+  }
+  sort(definitions.begin(), definitions.end());
+  vector<pair<Component *, Circuit *>> contents(children.size());
+  // circuit in the file for each child, no_circuits if it is not one
+  vector<size_t> defined_at(children.size(), no_circuits);
+  for (size_t first{0}; first < no_circuits; first += circuits_per_task) {
+    pool.submit([&, first]() {
+      const size_t last{min(no_circuits, first + circuits_per_task)};
+      for (size_t i{first}; i < last; i++) {
+        const CircuitLine &circ_line{circuit_lines[i]};
+        for (size_t c{circ_line.first_child};
+             c < circ_line.first_child + circ_line.no_children; c++) {
+          const string_view &child{children[c]};
+          if (Component *comp = find_component(child)) {
+            // the label is a component
+            contents[c].first = comp;
+            continue;
+          }
+          auto after = lower_bound(definitions.begin(), definitions.end(),
+                                   make_pair(child, i));
+          if ((after != definitions.begin()) &&
+              ((after - 1)->first == child)) {
+            defined_at[c] = (after - 1)->second;
+          } else {
+            contents[c].second = find_circuit(child);
+          }
+        }
+      }
+    });
+  }
+  pool.wait();
+
+  // only the circuits before the first one containing a label which is none
+  // of these are loaded
+  size_t no_loaded{no_circuits};
+  for (size_t i{0}; (i < no_circuits) && (no_loaded == no_circuits); i++) {
+    const CircuitLine &circ_line{circuit_lines[i]};
+    for (size_t c{circ_line.first_child};
+         c < circ_line.first_child + circ_line.no_children; c++) {
+      if ((contents[c].first == nullptr) && (contents[c].second == nullptr) &&
+          (defined_at[c] == no_circuits)) {
+        errors << "Save file line " << circ_line.line << ": unknown label "
+               << children[c] << ".\n";
+        no_loaded = i;
+        break;
+      }
+    }
+  }
+
+  // circuits, created and labelled in order
+  vector<Circuit *> circuits(no_loaded, nullptr);
+  for (size_t i{0}; i < no_loaded; i++) {
+    const CircuitLine &circ_line{circuit_lines[i]};
+    if (circ_line.parallel) {
+      // add a parallel circuit with the correct freq
+      circuits[i] = make<Parallel>(circ_line.frequency);
+    } else {
+      // add a series circuit with the correct freq
+      circuits[i] = make<Series>(circ_line.frequency);
+    }
+    // set the label to the one from the file
+    circuits[i]->set_label(file_label(circ_line.label));
+    for (size_t c{circ_line.first_child};
+         c < circ_line.first_child + circ_line.no_children; c++) {
+      if (defined_at[c] != no_circuits) {
+        // always an earlier circuit, so it has already been created
+        contents[c].second = circuits[defined_at[c]];
+      }
+    }
+  }
+
+  // connect and register the circuits in order
+  for (size_t i{0}; i < no_loaded; i++) {
+    Circuit *this_circuit{circuits[i]};
+    const CircuitLine &circ_line{circuit_lines[i]};
+    for (size_t c{circ_line.first_child};
+         c < circ_line.first_child + circ_line.no_children; c++) {
+      if (contents[c].first != nullptr) {
+        // the label is a component, add it to the circuit
+        this_circuit->add_component(contents[c].first);
+      } else if (contents[c].second != nullptr) {
+        // the label is a circuit, add this subcircuit to the circuit
+        this_circuit->add_subcircuit(contents[c].second);
+        // change the subcircuit's freq to match this circuit
+        contents[c].second->set_frequency(this_circuit->get_frequency());
+        messages << "Frequency of subcircuit changed to match the new "
+                    "circuit.\n";
+      }
+    }
+    // register the circuit once it is complete
+    insert(this_circuit);
+  }
+  if (no_loaded != no_circuits) {
+    throw(4);
+  }
+  if (invalid != nullptr) {
+    report_invalid();
+    throw(4);
+  }
+}
@@ -0,0 +1,37 @@
+/* project.h
+ * Interface for reading and writing projects in the text format:
+ *    #SaveFile <date and time saved>
+ *    [Components]
+ *      <label>  <type>  <value><unit>
+ *    [Circuits]
+ *      <label>  <frequency>Hz  <|Z|>   ( <labels of components/subcircuits> )
+ *    [End]
+ * Circuits are written after their subcircuits, so a project can be read back
+ * in a single pass. Reading tokenizes line-aligned chunks of the file in
+ * parallel without copying any of it, then creates and connects everything in
+ * file order, so the result is the same as reading the file one line at a
+ * time. Labels can be any length
+ *  Implementation:  project.cpp
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef PROJECT_H
+#define PROJECT_H
+
+#include <iostream> // streams
+#include <vector>   // vector container
+
+#include "circuit.h"   // circuit class
+#include "component.h" // component base class
+
+// write a project in the text format (stream, components, circuits)
+void write_project(ostream &, const vector<Component *> &,
+                   const vector<Circuit *> &);
+// read a project in the text format into the libraries. The line of an
+// invalid save file which could not be read, or which contains an unknown
+// label, is written to the stream for errors (stream, stream for progress
+// messages, stream for errors)
+void read_project(istream &, ostream &, ostream &);
+
+#endif
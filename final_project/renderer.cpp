@@ -0,0 +1,124 @@
+/* renderer.cpp
+ * Implementation of the Renderer class to format text in a buffer
+ *  Interface:      renderer.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <charconv> // to_chars
+#include <cstring>  // memcpy, strlen
+#include <iostream> // ostream sink
+#include <string>   // string type
+
+#include "renderer.h" // class interface
+
+#include "complex.h" // complex class
+
+namespace {
+// longest number to_chars can produce, with six significant figures or in
+// the shortest exact form
+const size_t max_number_length{32};
+} // namespace
+
+// renderer writing to a stream (stream)
+Renderer::Renderer(ostream &os)
+    : sink{os}, buffer(chunk_size + max_number_length), used{0} {}
+
+// destructor - writes anything left in the buffer
+Renderer::~Renderer() {
+  if (used > 0) {
+    sink.write(buffer.data(), used);
+  }
+}
+
+// make room for at least this many characters (characters). Full chunks are
+// written out, and the buffer only grows for text longer than a chunk
+void Renderer::reserve(const size_t &count) {
+  if (used + count > buffer.size()) {
+    if (used > 0) {
+      sink.write(buffer.data(), used);
+      used = 0;
+    }
+    if (count > buffer.size()) {
+      buffer.resize(count);
+    }
+  }
+}
+
+// append characters (characters, count)
+void Renderer::write(const char *text, const size_t &count) {
+  reserve(count);
+  memcpy(buffer.data() + used, text, count);
+  used += count;
+  if (used >= chunk_size) {
+    sink.write(buffer.data(), used);
+    used = 0;
+  }
+}
+
+// append text
+Renderer &Renderer::operator<<(const char *text) {
+  write(text, strlen(text));
+  return *this;
+}
+
+Renderer &Renderer::operator<<(const string &text) {
+  write(text.data(), text.length());
+  return *this;
+}
+
+Renderer &Renderer::operator<<(const char &c) {
+  write(&c, 1);
+  return *this;
+}
+
+// append numbers, formatted like the default ostream formatting (%g)
+Renderer &Renderer::operator<<(const double &x) {
+  reserve(max_number_length);
+  char *start{buffer.data() + used};
+  used = to_chars(start, start + max_number_length, x, chars_format::general,
+                  6)
+             .ptr -
+         buffer.data();
+  return *this;
+}
+
+// append a number in its shortest form which reads back as the same number
+void Renderer::write_exact(const double &x) {
+  reserve(max_number_length);
+  char *start{buffer.data() + used};
+  used = to_chars(start, start + max_number_length, x).ptr - buffer.data();
+}
+
+Renderer &Renderer::operator<<(const int &x) {
+  reserve(max_number_length);
+  char *start{buffer.data() + used};
+  used = to_chars(start, start + max_number_length, x).ptr - buffer.data();
+  return *this;
+}
+
+Renderer &Renderer::operator<<(const size_t &x) {
+  reserve(max_number_length);
+  char *start{buffer.data() + used};
+  used = to_chars(start, start + max_number_length, x).ptr - buffer.data();
+  return *this;
+}
+
+// append a complex number in the same form as its ostream operator
+Renderer &Renderer::operator<<(const Complex &z) {
+  *this << z.get_real();
+  if (!(z.get_imaginary() < 0)) {
+    // positive or zero, insert + sign
+    *this << '+';
+  }
+  return *this << z.get_imaginary() << 'i';
+}
+
+// write the buffer to the sink and flush it
+void Renderer::flush() {
+  if (used > 0) {
+    sink.write(buffer.data(), used);
+    used = 0;
+  }
+  sink.flush();
+}
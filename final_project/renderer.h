@@ -0,0 +1,63 @@
+/* renderer.h
+ * Interface for the Renderer class, which formats text into a reusable buffer
+ * and writes it to a stream in large chunks. Numbers are formatted with
+ * to_chars in the same style as the default ostream formatting (six
+ * significant figures), without going through the stream or its locale. The
+ * buffer is written when it fills, when flush is called and when the renderer
+ * is destroyed, so nothing else should write to the same stream while a
+ * renderer for it exists
+ *  Implementation:  renderer.cpp
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <cstddef>  // size_t
+#include <iostream> // ostream sink
+#include <string>   // string type
+#include <vector>   // vector buffer
+
+#include "complex.h" // complex class
+
+class Renderer {
+private:
+  ostream &sink;       // where the text goes
+  vector<char> buffer; // formatted text waiting to be written
+  size_t used;         // number of characters in the buffer
+
+  // make room for at least this many characters (characters)
+  void reserve(const size_t &);
+
+public:
+  // size of the chunks written to the sink
+  static const size_t chunk_size{1 << 16};
+
+  // renderer writing to a stream (stream)
+  explicit Renderer(ostream &);
+  // the buffer cannot be shared
+  Renderer(const Renderer &) = delete;
+  Renderer &operator=(const Renderer &) = delete;
+  // destructor - writes anything left in the buffer
+  ~Renderer();
+
+  // append text/numbers
+  Renderer &operator<<(const char *);
+  Renderer &operator<<(const string &);
+  Renderer &operator<<(const char &);
+  Renderer &operator<<(const double &);
+  Renderer &operator<<(const int &);
+  Renderer &operator<<(const size_t &);
+  Renderer &operator<<(const Complex &);
+  // append characters (characters, count)
+  void write(const char *, const size_t &);
+  // append a number with as many digits as it takes to read it back exactly
+  // (number)
+  void write_exact(const double &);
+
+  // write the buffer to the sink and flush it
+  void flush();
+};
+
+#endif
@@ -5,31 +5,14 @@
  *  Date:           29/03/17
  */
 
-#include <sstream> // stringstream
-#include <string>  // string for label
+#include <atomic> // counter
 
 #include "component.h" // component base class
 #include "resistor.h"  // resistor class interface
 
-int Resistor::resistor_count{0}; // initialise static data member
+atomic<uint32_t> Resistor::resistor_count{0}; // define static data member
 
-// parametrised constructor (resistance)
-Resistor::Resistor(const double &R) : Component(0, R, "R") {
-  resistor_count++;
-  // add resistor number to label
-  stringstream comp_label;
-  comp_label << label << resistor_count;
-  label = comp_label.str();
-}
-
-// destructor
-Resistor::~Resistor() {}
-
-// calculate impedence of component
-Complex Resistor::get_impedance(const double &freq) const {
-  Complex result; // use complex class
-  // Z = R
-  result.set_real(value);
-  result.set_imaginary(0);
-  return result;
-}
+// parametrised constructor (resistance), labelled with the resistor number
+Resistor::Resistor(const double &R)
+    : Component(component_kind::resistor, R,
+                Label{'R', ++resistor_count}) {}
@@ -9,21 +9,19 @@
 #ifndef RESISTOR_H
 #define RESISTOR_H
 
+#include <atomic>  // counter
+#include <cstdint> // fixed width integers
+
 #include "complex.h"
 #include "component.h"
 
 class Resistor : public Component {
 private:
-  static int resistor_count;
+  static atomic<uint32_t> resistor_count; // number of the last resistor
 
 public:
   // parametrised constructor (resistance)
   Resistor(const double &);
-  // destructor
-  ~Resistor();
-
-  // calculate impedence of component
-  Complex get_impedance(const double &) const;
 };
 
 #endif
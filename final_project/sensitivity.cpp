@@ -0,0 +1,110 @@
+/* sensitivity.cpp
+ * Implementation of the sensitivity analysis. The derivatives follow from the
+ * chain rule, with complex multiplication as everything is complex
+ * differentiable:
+ *    series    Z = sum Z_i          dZ/dZ_i = 1
+ *    parallel  Z = 1/sum(1/Z_i)     dZ/dZ_i = (Z/Z_i)^2
+ *    resistor  Z = R                dZ/dR = 1
+ *    inductor  Z = jwL              dZ/dL = jw
+ *    capacitor Z = 1/jwC            dZ/dC = -Z/C
+ *  Interface:      sensitivity.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <unordered_map> // indices of circuits and components
+#include <vector>        // vector container
+
+#include "sensitivity.h" // interface
+
+#include "circuit.h"   // circuit class
+#include "complex.h"   // complex class
+#include "component.h" // component base class
+#include "stats.h"     // performance counters
+
+namespace {
+// derivative of the impedance of an element with respect to its value
+// (element, frequency)
+Complex element_derivative(const Element &elem, const double &freq) {
+  switch (elem.kind) {
+  case component_kind::resistor:
+    return Complex{1, 0};
+  case component_kind::capacitor:
+    return Complex{0, 0} -
+           element_impedance(elem, freq) / Complex{elem.value, 0};
+  case component_kind::inductor:
+    return Complex{0, 2 * M_PI * freq / 1e6};
+  }
+  return Complex{};
+}
+
+// add the circuits below this one to the order after all of the circuits
+// above them, by adding them in postorder (circuit, index of each circuit
+// visited, postorder)
+void postorder(const Circuit *circ,
+               unordered_map<const Circuit *, size_t> &visited,
+               vector<const Circuit *> &order) {
+  visited[circ] = 0;
+  for (auto it : circ->get_subcircuits()) {
+    if (visited.find(it) == visited.end()) {
+      postorder(it, visited, order);
+    }
+  }
+  visited[circ] = order.size();
+  order.push_back(circ);
+}
+} // namespace
+
+// derivatives of the impedance of a circuit with respect to every component
+// in it (circuit)
+vector<Sensitivity> impedance_sensitivity(const Circuit &circ) {
+  stats::ScopedTimer timer{stats::sensitivity};
+  // forward pass, filling every cache in the circuit
+  circ.get_impedance();
+
+  // circuits with each one before everything it contains
+  unordered_map<const Circuit *, size_t> index;
+  vector<const Circuit *> order;
+  postorder(&circ, index, order);
+
+  // reverse pass. adjoint[i] is dZ/dZ_i of circuit order[i], complete once
+  // every circuit containing it has been visited
+  vector<Complex> adjoint(order.size());
+  adjoint.back() = Complex{1, 0};
+  vector<Sensitivity> result;
+  unordered_map<const Component *, size_t> found;
+  for (size_t n{order.size()}; n-- > 0;) {
+    const Circuit *node{order[n]};
+    const double freq{node->get_frequency()};
+    const bool parallel{dynamic_cast<const Parallel *>(node) != nullptr};
+    const Complex z{node->get_impedance()};
+    for (auto it : node->get_components()) {
+      // adjoint of the component's impedance, then of its value
+      Complex local{adjoint[n]};
+      if (parallel) {
+        const Complex ratio{z / it->get_impedance(freq)};
+        local = local * ratio * ratio;
+      }
+      const Complex derivative{local *
+                               element_derivative(it->get_element(), freq)};
+      auto entry = found.find(it);
+      if (entry == found.end()) {
+        found[it] = result.size();
+        result.push_back(Sensitivity{it, derivative});
+      } else {
+        Complex &total{result[entry->second].derivative};
+        total = total + derivative;
+      }
+    }
+    for (auto it : node->get_subcircuits()) {
+      Complex local{adjoint[n]};
+      if (parallel) {
+        const Complex ratio{z / it->get_impedance()};
+        local = local * ratio * ratio;
+      }
+      Complex &total{adjoint[index[it]]};
+      total = total + local;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,35 @@
+/* sensitivity.h
+ * Interface for sensitivity analysis: the derivative of the impedance of a
+ * circuit with respect to the value of every component in it. The impedances
+ * are found in one forward pass (the circuits' own cached evaluation) and the
+ * derivatives in one reverse pass from the top of the circuit down, so the
+ * cost is linear in the size of the circuit rather than one evaluation per
+ * component. Subcircuits used in several places are visited once, after
+ * every circuit containing them
+ *  Implementation:  sensitivity.cpp
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef SENSITIVITY_H
+#define SENSITIVITY_H
+
+#include <vector> // vector container
+
+#include "circuit.h"   // circuit class
+#include "complex.h"   // complex class
+#include "component.h" // component base class
+
+// derivative of the impedance of a circuit with respect to the value of one
+// component, per unit of the value (per ohm, microfarad or microhenry)
+struct Sensitivity {
+  Component *component;
+  Complex derivative;
+};
+
+// derivatives of the impedance of a circuit with respect to every component
+// in it, in the order the components are first found (circuit). A component
+// used more than once gets the total of its derivatives
+vector<Sensitivity> impedance_sensitivity(const Circuit &);
+
+#endif
@@ -0,0 +1,218 @@
+/* snapshot.cpp
+ * Implementation of circuit and library snapshots. Each snapshot keeps the
+ * order in which to evaluate everything below it, worked out when it is first
+ * evaluated, so evaluating it is one pass over an array with no recursion or
+ * lookups
+ *  Interface:      snapshot.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <memory>        // shared_ptr
+#include <mutex>         // call_once
+#include <string>        // labels
+#include <unordered_map> // snapshots of shared circuits
+#include <utility>       // move
+#include <vector>        // vector container
+
+#include "snapshot.h" // interface
+
+#include "circuit.h"   // circuit class
+#include "component.h" // component base class
+#include "library.h"   // circuit library
+#include "stats.h"     // performance counters
+
+namespace {
+// snapshot of a circuit, reusing the snapshots of circuits already taken
+// (circuit, snapshots taken so far)
+SnapshotPtr snapshot_of(const Circuit *circ,
+                        unordered_map<const Circuit *, SnapshotPtr> &taken) {
+  auto found = taken.find(circ);
+  if (found != taken.end()) {
+    return found->second;
+  }
+  vector<ComponentSnapshot> components;
+  components.reserve(circ->get_components().size());
+  for (auto it : circ->get_components()) {
+    components.push_back(
+        {SnapshotLabel{it->get_label_id()}, it->get_element()});
+  }
+  vector<SnapshotPtr> subcircuits;
+  subcircuits.reserve(circ->get_subcircuits().size());
+  for (auto it : circ->get_subcircuits()) {
+    subcircuits.push_back(snapshot_of(it, taken));
+  }
+  SnapshotPtr snapshot{make_shared<const CircuitSnapshot>(
+      SnapshotLabel{circ->get_label_id()},
+      dynamic_cast<const Parallel *>(circ) != nullptr, move(components),
+      move(subcircuits))};
+  taken.emplace(circ, snapshot);
+  return snapshot;
+}
+} // namespace
+
+//-----------------------------------------------------------------------------
+//---SnapshotLabel
+//-----------------------------------------------------------------------------
+// copy of a label
+SnapshotLabel::SnapshotLabel(const Label &lab)
+    : numbered{lab.is_numbered()}, label{numbered ? lab : Label{0, 0}},
+      text{numbered ? string{} : string{lab.stored_text()}} {}
+
+// whether this label has this text, comparing numbered labels as numbers
+bool SnapshotLabel::matches(const string_view &other) const {
+  Label other_label{0, 0};
+  if (Label::parse(other, other_label)) {
+    return numbered && (label == other_label);
+  }
+  return !numbered && (text == other);
+}
+
+// text of the label
+string SnapshotLabel::str() const { return numbered ? label.str() : text; }
+
+//-----------------------------------------------------------------------------
+//---SnapshotOrder
+//-----------------------------------------------------------------------------
+// add a snapshot after everything below it
+void SnapshotOrder::add(
+    const CircuitSnapshot &circ,
+    unordered_map<const CircuitSnapshot *, uint32_t> &positions) {
+  if (positions.count(&circ) != 0) {
+    // already in the order through another circuit
+    return;
+  }
+  for (auto &it : circ.subcircuits) {
+    add(*it, positions);
+  }
+  append(&circ, positions);
+}
+
+// add one snapshot after its subcircuits
+void SnapshotOrder::append(
+    const CircuitSnapshot *circ,
+    unordered_map<const CircuitSnapshot *, uint32_t> &positions) {
+  if (!positions.emplace(circ, entries.size()).second) {
+    // already in the order through another circuit
+    return;
+  }
+  for (auto &it : circ->subcircuits) {
+    slots.push_back(positions.at(it.get()));
+  }
+  entries.push_back(circ);
+}
+
+// impedance of every entry, subcircuits first
+void SnapshotOrder::evaluate(const double &freq, Complex *values) const {
+  const uint32_t *slot{slots.data()};
+  for (size_t i{0}; i < entries.size(); i++) {
+    values[i] = entries[i]->combine(freq, values, slot);
+    slot += entries[i]->subcircuits.size();
+  }
+}
+
+//-----------------------------------------------------------------------------
+//---CircuitSnapshot
+//-----------------------------------------------------------------------------
+// snapshot with these contents
+CircuitSnapshot::CircuitSnapshot(const SnapshotLabel &circ_label,
+                                 const bool &is_parallel,
+                                 vector<ComponentSnapshot> comps,
+                                 vector<SnapshotPtr> subs)
+    : label{circ_label}, parallel{is_parallel}, components{move(comps)},
+      subcircuits{move(subs)} {}
+
+// snapshot of a circuit
+SnapshotPtr CircuitSnapshot::take(const Circuit &circ) {
+  unordered_map<const Circuit *, SnapshotPtr> taken;
+  return snapshot_of(&circ, taken);
+}
+
+// impedance from the components and the impedances of the subcircuits, added
+// in the same order as Series and Parallel do. Nothing is printed for a
+// capacitor at 0Hz, as this runs on many threads at once
+Complex CircuitSnapshot::combine(const double &freq, const Complex *values,
+                                 const uint32_t *slot) const {
+  Complex temp{0, 0};
+  if (!parallel) {
+    for (auto &it : components) {
+      temp = temp + quiet_element_impedance(it.element, freq);
+    }
+    for (size_t i{0}; i < subcircuits.size(); i++) {
+      temp = temp + values[slot[i]];
+    }
+    return temp;
+  }
+  Complex one{1, 0};
+  for (auto &it : components) {
+    temp = temp + one / quiet_element_impedance(it.element, freq);
+  }
+  for (size_t i{0}; i < subcircuits.size(); i++) {
+    temp = temp + one / values[slot[i]];
+  }
+  return one / temp;
+}
+
+// impedance at a frequency. Each thread keeps its own buffer for the
+// impedances, so repeated evaluations do not allocate
+Complex CircuitSnapshot::impedance_at(const double &freq) const {
+  call_once(ordered, [this]() {
+    unordered_map<const CircuitSnapshot *, uint32_t> positions;
+    order.add(*this, positions);
+  });
+  thread_local vector<Complex> values;
+  if (values.size() < order.size()) {
+    values.resize(order.size());
+  }
+  order.evaluate(freq, values.data());
+  // this circuit is the last entry of its own order
+  return values[order.size() - 1];
+}
+
+//-----------------------------------------------------------------------------
+//---LibrarySnapshot
+//-----------------------------------------------------------------------------
+// snapshot of a list of circuits
+LibrarySnapshot::LibrarySnapshot(vector<SnapshotPtr> circs)
+    : circuits{move(circs)} {
+  unordered_map<const CircuitSnapshot *, uint32_t> order_positions;
+  positions.reserve(circuits.size());
+  for (auto &it : circuits) {
+    order.add(*it, order_positions);
+    positions.push_back(order_positions.at(it.get()));
+  }
+}
+
+// snapshot of the circuit library
+shared_ptr<const LibrarySnapshot> LibrarySnapshot::take() {
+  unordered_map<const Circuit *, SnapshotPtr> taken;
+  vector<SnapshotPtr> circs;
+  circs.reserve(libs::circuit_lib.size());
+  for (auto it : libs::circuit_lib) {
+    circs.push_back(snapshot_of(it, taken));
+  }
+  return make_shared<const LibrarySnapshot>(move(circs));
+}
+
+// the last circuit with a label, as the library's registry would find
+SnapshotPtr LibrarySnapshot::find(const string &text) const {
+  for (auto it = circuits.rbegin(); it != circuits.rend(); it++) {
+    if ((*it)->get_label().matches(text)) {
+      return *it;
+    }
+  }
+  return nullptr;
+}
+
+// impedance of every circuit at a frequency
+vector<Complex> LibrarySnapshot::impedances_at(const double &freq) const {
+  stats::ScopedTimer timer{stats::snapshot_evaluate};
+  vector<Complex> values(order.size());
+  order.evaluate(freq, values.data());
+  vector<Complex> results;
+  results.reserve(circuits.size());
+  for (auto it : positions) {
+    results.push_back(values[it]);
+  }
+  return results;
+}
@@ -0,0 +1,151 @@
+/* snapshot.h
+ * Interface for immutable snapshots of circuits and of the circuit library.
+ * A snapshot copies the labels, kinds and values out of a circuit and never
+ * changes afterwards. It has no frequency, which is an argument to
+ * impedance_at, and no cache, so any number of threads can evaluate the same
+ * snapshot at different frequencies without locking. Snapshots are reference
+ * counted: subcircuits are shared between every snapshot which contains them,
+ * and a snapshot stays valid after the library is edited, until the last
+ * reference to it goes. Edits are made to the library as usual and a new
+ * snapshot taken of the result, or to a LibraryVersion. A circuit snapshot
+ * works out the order to evaluate everything below it the first time it is
+ * evaluated, so making one only costs its own contents. Labels which are not
+ * a letter and a number are copied into the snapshot, so a snapshot can be
+ * printed on any thread and after the library has been cleared
+ *  Implementation:  snapshot.cpp
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>       // fixed width integers
+#include <memory>        // shared_ptr
+#include <mutex>         // once_flag
+#include <string>        // labels
+#include <string_view>   // labels to match
+#include <unordered_map> // positions in an evaluation order
+#include <vector>        // vector container
+
+#include "circuit.h"   // circuit class
+#include "complex.h"   // complex class
+#include "component.h" // component base class
+#include "label.h"     // numbered labels
+
+class CircuitSnapshot;
+typedef shared_ptr<const CircuitSnapshot> SnapshotPtr;
+
+// label in a snapshot. Numbered labels are kept as they are, and the text of
+// any other label is copied out of libs::labels
+class SnapshotLabel {
+private:
+  bool numbered; // whether the label is a letter and a number
+  Label label;   // the label, if it is numbered
+  string text;   // the text of the label, if it is not
+
+public:
+  // copy of a label (label)
+  explicit SnapshotLabel(const Label &);
+
+  // whether this label has this text (text)
+  bool matches(const string_view &) const;
+  // text of the label
+  string str() const;
+};
+
+// component in a snapshot
+struct ComponentSnapshot {
+  SnapshotLabel label;
+  Element element;
+};
+
+// distinct circuits below and including some snapshots, each after its
+// subcircuits, so that each is evaluated once however often it is shared
+class SnapshotOrder {
+private:
+  vector<const CircuitSnapshot *> entries; // circuits in evaluation order
+  vector<uint32_t> slots; // positions of the subcircuits of each entry
+
+public:
+  // add a snapshot and everything below it which is not already in the order
+  // (snapshot, position of each entry)
+  void add(const CircuitSnapshot &,
+           unordered_map<const CircuitSnapshot *, uint32_t> &);
+  // add one snapshot whose subcircuits are already in the order (snapshot,
+  // position of each entry)
+  void append(const CircuitSnapshot *,
+              unordered_map<const CircuitSnapshot *, uint32_t> &);
+  // number of entries
+  size_t size() const { return entries.size(); }
+  // entries in evaluation order, and the positions of the subcircuits of
+  // each entry one after another
+  const vector<const CircuitSnapshot *> &get_entries() const {
+    return entries;
+  }
+  const vector<uint32_t> &get_slots() const { return slots; }
+  // impedance of every entry at a frequency (frequency, impedances)
+  void evaluate(const double &, Complex *) const;
+};
+
+class CircuitSnapshot {
+  friend class SnapshotOrder;
+  friend class LibraryVersion;
+
+private:
+  SnapshotLabel label;
+  bool parallel;
+  vector<ComponentSnapshot> components;
+  vector<SnapshotPtr> subcircuits;
+  mutable once_flag ordered;   // whether the order has been worked out
+  mutable SnapshotOrder order; // this circuit and everything below it
+
+  // impedance from the impedances of the subcircuits (frequency, impedances
+  // of the entries of an order, positions of the subcircuits in it)
+  Complex combine(const double &, const Complex *, const uint32_t *) const;
+
+public:
+  // snapshot with these contents (label, whether it is parallel, components,
+  // subcircuits)
+  CircuitSnapshot(const SnapshotLabel &, const bool &,
+                  vector<ComponentSnapshot>, vector<SnapshotPtr>);
+
+  // snapshot of a circuit and everything below it (circuit)
+  static SnapshotPtr take(const Circuit &);
+
+  // impedance at a frequency, with no side effects. Sums are made in the same
+  // order as Circuit::get_impedance, so the results are identical, but unlike
+  // it no error is printed for a capacitor at 0Hz or of 0F (frequency)
+  Complex impedance_at(const double &) const;
+
+  const SnapshotLabel &get_label() const { return label; }
+  bool is_parallel() const { return parallel; }
+  const vector<ComponentSnapshot> &get_components() const {
+    return components;
+  }
+  const vector<SnapshotPtr> &get_subcircuits() const { return subcircuits; }
+};
+
+class LibrarySnapshot {
+private:
+  vector<SnapshotPtr> circuits; // in library order
+  SnapshotOrder order;          // every circuit in the library
+  vector<uint32_t> positions;   // position of each circuit in the order
+
+public:
+  // snapshot of a list of circuits (circuits)
+  LibrarySnapshot(vector<SnapshotPtr>);
+
+  // snapshot of the circuit library. Circuits shared in the library are
+  // shared in the snapshot
+  static shared_ptr<const LibrarySnapshot> take();
+
+  const vector<SnapshotPtr> &get_circuits() const { return circuits; }
+  // the last circuit with a label, nullptr if there is none (label)
+  SnapshotPtr find(const string &) const;
+  // impedance of every circuit at a frequency in library order, evaluating
+  // each distinct circuit once, with no side effects (frequency)
+  vector<Complex> impedances_at(const double &) const;
+};
+
+#endif
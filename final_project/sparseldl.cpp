@@ -0,0 +1,172 @@
+/* sparseldl.cpp
+ * Minimum degree ordering for the sparse LDL^T factorisation. The unknowns
+ * are eliminated one at a time from the graph of the matrix, always choosing
+ * one with the fewest neighbours. Eliminating an unknown joins up all of its
+ * neighbours, which is exactly the fill-in it causes. Unknowns which end up
+ * with the same neighbours as each other are merged into one supervariable
+ * and eliminated together, which keeps the graph small for meshes
+ *  Interface:      sparseldl.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <algorithm>  // set_union, lower_bound, sort
+#include <functional> // greater
+#include <iterator>   // back_inserter
+#include <queue>      // priority_queue
+#include <utility>    // pair
+#include <vector>     // vector container
+
+#include "sparseldl.h" // interface
+
+namespace {
+// remove an unknown from a sorted neighbour list (list, unknown)
+void remove_from(vector<int> &list, const int &i) {
+  auto it = lower_bound(list.begin(), list.end(), i);
+  if ((it != list.end()) && (*it == i)) {
+    list.erase(it);
+  }
+}
+
+// check whether u and w have the same neighbours apart from each other
+// (neighbours of u, neighbours of w, u, w)
+bool indistinguishable(const vector<int> &a, const vector<int> &b,
+                       const int &u, const int &w) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  auto i = a.begin();
+  auto j = b.begin();
+  while ((i != a.end()) || (j != b.end())) {
+    if ((i != a.end()) && (*i == w)) {
+      i++;
+    } else if ((j != b.end()) && (*j == u)) {
+      j++;
+    } else if ((i == a.end()) || (j == b.end()) || (*i != *j)) {
+      return false;
+    } else {
+      i++;
+      j++;
+    }
+  }
+  return true;
+}
+} // namespace
+
+// minimum degree ordering of a symmetric pattern (size, rows, columns of the
+// entries). Returns the order to eliminate the unknowns in
+vector<int> minimum_degree_order(const int &n, const vector<int> &rows,
+                                 const vector<int> &cols) {
+  // sorted neighbour lists without the diagonal or repeats
+  vector<vector<int>> adjacent(n);
+  for (size_t e{0}; e < rows.size(); e++) {
+    if (rows[e] != cols[e]) {
+      adjacent[rows[e]].push_back(cols[e]);
+      adjacent[cols[e]].push_back(rows[e]);
+    }
+  }
+  for (auto &it : adjacent) {
+    sort(it.begin(), it.end());
+    it.erase(unique(it.begin(), it.end()), it.end());
+  }
+
+  // supervariables: weight is the number of unknowns each one stands for and
+  // the unknowns merged into it are chained through next
+  vector<int> weight(n, 1);
+  vector<int> next(n, -1);
+  vector<int> last(n);
+  vector<int> degree(n);
+  for (int i{0}; i < n; i++) {
+    last[i] = i;
+    degree[i] = adjacent[i].size();
+  }
+
+  // supervariables by degree. Degrees only change for neighbours of the one
+  // being eliminated, so stale entries are pushed again and skipped later
+  typedef pair<int, int> entry; // degree, supervariable
+  priority_queue<entry, vector<entry>, greater<entry>> queue;
+  for (int i{0}; i < n; i++) {
+    queue.push(entry{degree[i], i});
+  }
+
+  vector<int> order;
+  order.reserve(n);
+  vector<bool> eliminated(n, false);
+  vector<int> merged;
+  vector<pair<size_t, int>> hashes; // neighbour hash, supervariable
+  while (!queue.empty()) {
+    const entry top{queue.top()};
+    queue.pop();
+    const int v{top.second};
+    if (eliminated[v] || (top.first != degree[v])) {
+      continue;
+    }
+    for (int i{v}; i != -1; i = next[i]) {
+      order.push_back(i);
+    }
+    eliminated[v] = true;
+    const vector<int> clique{move(adjacent[v])};
+    adjacent[v] = vector<int>();
+
+    // every neighbour of v becomes connected to every other neighbour
+    hashes.clear();
+    for (auto u : clique) {
+      vector<int> &list{adjacent[u]};
+      merged.clear();
+      set_union(list.begin(), list.end(), clique.begin(), clique.end(),
+                back_inserter(merged));
+      // v is gone and u is not its own neighbour
+      remove_from(merged, v);
+      remove_from(merged, u);
+      list.swap(merged);
+      size_t hash{(size_t)u};
+      for (auto it : list) {
+        hash += it;
+      }
+      hashes.push_back(make_pair(hash, u));
+    }
+
+    // merge neighbours which now have the same neighbours as each other.
+    // They are all in the clique, so only the clique needs to be checked
+    sort(hashes.begin(), hashes.end());
+    for (size_t a{0}; a < hashes.size(); a++) {
+      const int u{hashes[a].second};
+      if (eliminated[u]) {
+        continue;
+      }
+      for (size_t b{a + 1};
+           (b < hashes.size()) && (hashes[b].first == hashes[a].first); b++) {
+        const int w{hashes[b].second};
+        if (eliminated[w] ||
+            !indistinguishable(adjacent[u], adjacent[w], u, w)) {
+          continue;
+        }
+        // w joins u and leaves the graph
+        weight[u] += weight[w];
+        next[last[u]] = w;
+        last[u] = last[w];
+        eliminated[w] = true;
+        for (auto x : adjacent[w]) {
+          if (x != u) {
+            remove_from(adjacent[x], w);
+          }
+        }
+        remove_from(adjacent[u], w);
+        vector<int>().swap(adjacent[w]);
+      }
+    }
+
+    // new degrees are the number of unknowns next to each supervariable
+    for (auto u : clique) {
+      if (!eliminated[u]) {
+        int d{0};
+        for (auto it : adjacent[u]) {
+          d += weight[it];
+        }
+        degree[u] = d;
+        queue.push(entry{d, u});
+      }
+    }
+  }
+  return order;
+}
@@ -0,0 +1,416 @@
+/* sparseldl.h
+ * SparseLDL class template to factorise and solve sparse symmetric systems
+ * A x = b as P A P^T = L D L^T. The rows and columns are reordered with a
+ * minimum degree ordering to keep the fill-in of L small, and the structure
+ * of L is worked out once so that matrices with the same pattern but
+ * different values (e.g. the same network at different frequencies) can be
+ * factorised without allocating. No complex conjugates are taken, so complex
+ * symmetric matrices such as admittance matrices work as well as real ones.
+ * The LDL^T does not pivot, so a pivot which is tiny next to the rest of its
+ * column (e.g. where the admittances of an inductor and a capacitor cancel at
+ * resonance) switches that factorisation to a sparse LU with partial pivoting
+ * in the same order, which allocates as it goes
+ *  Implementation:  sparseldl.cpp (ordering)
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef SPARSELDL_H
+#define SPARSELDL_H
+
+#include <algorithm> // max
+#include <cmath>     // fabs
+#include <cstddef>   // size_t
+#include <vector>    // vector container
+
+#include "complex.h" // complex class
+
+using namespace std;
+
+// minimum degree ordering of a symmetric pattern (size, rows, columns of the
+// entries). Returns the order to eliminate the unknowns in
+vector<int> minimum_degree_order(const int &, const vector<int> &,
+                                 const vector<int> &);
+
+// size of an entry, for comparing pivots
+inline double magnitude(const double &x) { return fabs(x); }
+inline double magnitude(const Complex &z) { return z.modulus(); }
+
+// LDL^T pivots smaller than this fraction of the largest entry in their
+// column switch to the pivoted LU
+const double pivot_tolerance{1e-3};
+// the LU keeps the diagonal as the pivot unless another entry is larger than
+// it by more than this factor, which keeps the fill close to the ordering's
+const double diagonal_preference{10};
+
+template <class T> class SparseLDL {
+private:
+  int n;                 // number of unknowns
+  vector<int> perm;      // perm[new] = old
+  vector<int> pinv;      // pinv[old] = new
+  vector<int> Ap;        // column pointers of the permuted upper triangle
+  vector<int> Ai;        // row indices of the permuted upper triangle
+  vector<int> position;  // position in Ai/Ax of each entry given
+  vector<T> Ax;          // values of the permuted upper triangle
+  vector<int> parent;    // elimination tree
+  vector<int> Lp;        // column pointers of L
+  vector<int> Li;        // row indices of L
+  vector<T> Lx;          // values of L
+  vector<T> D;           // diagonal
+  vector<int> Lnz;       // workspace: entries in each column of L so far
+  vector<int> flag;      // workspace: visited flags
+  vector<int> pattern;   // workspace: nonzero pattern of a row of L
+  vector<T> Y;           // workspace: row of L being calculated
+  mutable vector<T> X;   // workspace: permuted right hand side
+  vector<double> scale;  // workspace: largest entry in each column
+
+  // pivoted LU of the permuted matrix, used when the LDL^T breaks down
+  bool pivoted;           // whether the last factorisation is the LU
+  vector<int> Cp;         // column pointers of the whole permuted matrix
+  vector<int> Ci;         // row indices of the whole permuted matrix
+  vector<int> source;     // entry of Ax each entry of the whole matrix is
+  vector<int> row_pivot;  // row_pivot[row] = step it was the pivot at
+  vector<int> LUp;        // column pointers of the lower factor
+  vector<int> LUi;        // row indices of the lower factor, without its
+                          // unit diagonal
+  vector<T> LUx;          // values of the lower factor
+  vector<int> Up;         // column pointers of the upper factor
+  vector<int> Ui;         // row indices of the upper factor
+  vector<T> Ux;           // values of the upper factor, diagonal last
+  vector<int> stack;      // workspace: depth first search
+  vector<int> next_child; // workspace: where the search is up to at each level
+
+  // rows reached from column k of the matrix through the columns of the lower
+  // factor so far, in topological order from pattern[top] (column). Returns
+  // top
+  int reach(const int &k) {
+    int top{n};
+    for (int p{Cp[k]}; p < Cp[k + 1]; p++) {
+      if (flag[Ci[p]] == k) {
+        continue;
+      }
+      int head{0};
+      stack[0] = Ci[p];
+      flag[Ci[p]] = k;
+      next_child[0] = row_pivot[Ci[p]] < 0 ? 0 : LUp[row_pivot[Ci[p]]];
+      while (head >= 0) {
+        const int j{row_pivot[stack[head]]};
+        const int end{j < 0 ? 0 : LUp[j + 1]};
+        bool done{true};
+        while (next_child[head] < end) {
+          const int i{LUi[next_child[head]++]};
+          if (flag[i] != k) {
+            flag[i] = k;
+            head++;
+            stack[head] = i;
+            next_child[head] = row_pivot[i] < 0 ? 0 : LUp[row_pivot[i]];
+            done = false;
+            break;
+          }
+        }
+        if (done) {
+          pattern[--top] = stack[head--];
+        }
+      }
+    }
+    return top;
+  }
+
+  // left-looking LU with partial pivoting of the values in Ax, keeping the
+  // column order. Returns false if it is singular
+  bool factorise_pivoted() {
+    if (Cp.empty()) {
+      // both triangles of the permuted matrix, pointing back at Ax
+      Cp.assign(n + 1, 0);
+      for (int j{0}; j < n; j++) {
+        for (int p{Ap[j]}; p < Ap[j + 1]; p++) {
+          Cp[j + 1]++;
+          if (Ai[p] != j) {
+            Cp[Ai[p] + 1]++;
+          }
+        }
+      }
+      for (int k{0}; k < n; k++) {
+        Cp[k + 1] += Cp[k];
+      }
+      vector<int> next(Cp.begin(), Cp.end() - 1);
+      Ci.assign(Cp[n], 0);
+      source.assign(Cp[n], 0);
+      for (int j{0}; j < n; j++) {
+        for (int p{Ap[j]}; p < Ap[j + 1]; p++) {
+          Ci[next[j]] = Ai[p];
+          source[next[j]++] = p;
+          if (Ai[p] != j) {
+            Ci[next[Ai[p]]] = j;
+            source[next[Ai[p]]++] = p;
+          }
+        }
+      }
+      stack.assign(n, 0);
+      next_child.assign(n, 0);
+    }
+    row_pivot.assign(n, -1);
+    LUp.assign(1, 0);
+    LUi.clear();
+    LUx.clear();
+    Up.assign(1, 0);
+    Ui.clear();
+    Ux.clear();
+    for (auto &it : flag) {
+      it = -1;
+    }
+    for (int k{0}; k < n; k++) {
+      // solve for column k with the columns of the factors so far
+      const int top{reach(k)};
+      for (int t{top}; t < n; t++) {
+        Y[pattern[t]] = T{};
+      }
+      for (int p{Cp[k]}; p < Cp[k + 1]; p++) {
+        Y[Ci[p]] = Y[Ci[p]] + Ax[source[p]];
+      }
+      for (int t{top}; t < n; t++) {
+        const int j{row_pivot[pattern[t]]};
+        if (j < 0) {
+          continue;
+        }
+        const T yj{Y[pattern[t]]};
+        for (int p{LUp[j]}; p < LUp[j + 1]; p++) {
+          Y[LUi[p]] = Y[LUi[p]] - LUx[p] * yj;
+        }
+      }
+      // rows already pivoted on go in U, the largest of the rest is the pivot
+      int pivot_row{-1};
+      double largest{0};
+      for (int t{top}; t < n; t++) {
+        const int i{pattern[t]};
+        if (row_pivot[i] >= 0) {
+          Ui.push_back(row_pivot[i]);
+          Ux.push_back(Y[i]);
+        } else if (magnitude(Y[i]) > largest) {
+          pivot_row = i;
+          largest = magnitude(Y[i]);
+        }
+      }
+      if (pivot_row < 0) {
+        for (int t{top}; t < n; t++) {
+          Y[pattern[t]] = T{};
+        }
+        return false;
+      }
+      if ((row_pivot[k] < 0) && (flag[k] == k) &&
+          (magnitude(Y[k]) * diagonal_preference >= largest)) {
+        pivot_row = k;
+      }
+      const T pivot{Y[pivot_row]};
+      Ui.push_back(k);
+      Ux.push_back(pivot);
+      Up.push_back(Ui.size());
+      row_pivot[pivot_row] = k;
+      for (int t{top}; t < n; t++) {
+        const int i{pattern[t]};
+        if (row_pivot[i] < 0) {
+          LUi.push_back(i);
+          LUx.push_back(Y[i] / pivot);
+        }
+        Y[i] = T{};
+      }
+      LUp.push_back(LUi.size());
+    }
+    // number the rows of the lower factor by pivot step
+    for (auto &it : LUi) {
+      it = row_pivot[it];
+    }
+    return true;
+  }
+
+public:
+  // analyse the pattern of the matrix (size, rows, columns). Each entry (i, j)
+  // stands for both A(i, j) and A(j, i), and repeated entries are added
+  SparseLDL(const int &size, const vector<int> &rows,
+            const vector<int> &cols)
+      : n{size} {
+    // fill-reducing ordering
+    perm = minimum_degree_order(n, rows, cols);
+    pinv.assign(n, 0);
+    for (int k{0}; k < n; k++) {
+      pinv[perm[k]] = k;
+    }
+
+    // permuted upper triangle in compressed column form, keeping repeats as
+    // separate entries (the factorisation adds them together)
+    const size_t entries{rows.size()};
+    Ap.assign(n + 1, 0);
+    for (size_t e{0}; e < entries; e++) {
+      Ap[max(pinv[rows[e]], pinv[cols[e]]) + 1]++;
+    }
+    for (int k{0}; k < n; k++) {
+      Ap[k + 1] += Ap[k];
+    }
+    vector<int> next(Ap.begin(), Ap.end() - 1);
+    Ai.assign(entries, 0);
+    position.assign(entries, 0);
+    for (size_t e{0}; e < entries; e++) {
+      const int i{pinv[rows[e]]};
+      const int j{pinv[cols[e]]};
+      const int p{next[max(i, j)]++};
+      Ai[p] = min(i, j);
+      position[e] = p;
+    }
+    Ax.assign(entries, T{});
+
+    // elimination tree and the number of entries in each column of L
+    parent.assign(n, -1);
+    Lnz.assign(n, 0);
+    flag.assign(n, 0);
+    for (int k{0}; k < n; k++) {
+      flag[k] = k;
+      for (int p{Ap[k]}; p < Ap[k + 1]; p++) {
+        // follow the path from i to the root of the tree, stopping at
+        // anything already visited in this row
+        for (int i{Ai[p]}; flag[i] != k; i = parent[i]) {
+          if (parent[i] == -1) {
+            parent[i] = k;
+          }
+          Lnz[i]++;
+          flag[i] = k;
+        }
+      }
+    }
+    Lp.assign(n + 1, 0);
+    for (int k{0}; k < n; k++) {
+      Lp[k + 1] = Lp[k] + Lnz[k];
+    }
+    Li.assign(Lp[n], 0);
+    Lx.assign(Lp[n], T{});
+    D.assign(n, T{});
+    pattern.assign(n, 0);
+    Y.assign(n, T{});
+    X.assign(n, T{});
+    scale.assign(n, 0);
+    pivoted = false;
+  }
+
+  // number of unknowns and number of entries in L
+  int size() const { return n; }
+  int get_fill() const { return Lp[n]; }
+
+  // whether the last factorisation had to pivot
+  bool is_pivoted() const { return pivoted; }
+
+  // factorise the matrix with these values, in the same order as the entries
+  // given to the constructor (values). Returns false if it is singular
+  bool factorise(const vector<T> &values) {
+    for (auto &it : Ax) {
+      it = T{};
+    }
+    for (size_t e{0}; e < values.size(); e++) {
+      Ax[position[e]] = Ax[position[e]] + values[e];
+    }
+    for (auto &it : scale) {
+      it = 0;
+    }
+    for (int j{0}; j < n; j++) {
+      for (int p{Ap[j]}; p < Ap[j + 1]; p++) {
+        scale[j] = max(scale[j], magnitude(Ax[p]));
+        scale[Ai[p]] = max(scale[Ai[p]], magnitude(Ax[p]));
+      }
+    }
+    pivoted = false;
+    // up-looking LDL^T, one row of L at a time
+    for (int k{0}; k < n; k++) {
+      Y[k] = T{};
+      int top{n};
+      flag[k] = k;
+      Lnz[k] = 0;
+      for (int p{Ap[k]}; p < Ap[k + 1]; p++) {
+        int i{Ai[p]};
+        Y[i] = Y[i] + Ax[p];
+        // pattern of row k of L is the path from i up the elimination tree
+        int len{0};
+        for (; flag[i] != k; i = parent[i]) {
+          pattern[len++] = i;
+          flag[i] = k;
+        }
+        while (len > 0) {
+          pattern[--top] = pattern[--len];
+        }
+      }
+      D[k] = Y[k];
+      Y[k] = T{};
+      for (; top < n; top++) {
+        const int i{pattern[top]};
+        const T yi{Y[i]};
+        Y[i] = T{};
+        const int end{Lp[i] + Lnz[i]};
+        for (int p{Lp[i]}; p < end; p++) {
+          Y[Li[p]] = Y[Li[p]] - Lx[p] * yi;
+        }
+        const T l_ki{yi / D[i]};
+        D[k] = D[k] - l_ki * yi;
+        Li[end] = k;
+        Lx[end] = l_ki;
+        Lnz[i]++;
+      }
+      if (magnitude(D[k]) <= pivot_tolerance * scale[k]) {
+        pivoted = true;
+        return factorise_pivoted();
+      }
+    }
+    return true;
+  }
+
+  // solve A x = b using the last factorisation, overwriting b with x (b)
+  void solve(T *b) const {
+    if (pivoted) {
+      solve_pivoted(b);
+      return;
+    }
+    for (int k{0}; k < n; k++) {
+      X[k] = b[perm[k]];
+    }
+    // L y = b
+    for (int j{0}; j < n; j++) {
+      for (int p{Lp[j]}; p < Lp[j + 1]; p++) {
+        X[Li[p]] = X[Li[p]] - Lx[p] * X[j];
+      }
+    }
+    // D z = y
+    for (int j{0}; j < n; j++) {
+      X[j] = X[j] / D[j];
+    }
+    // L^T x = z
+    for (int j{n - 1}; j >= 0; j--) {
+      for (int p{Lp[j]}; p < Lp[j + 1]; p++) {
+        X[j] = X[j] - Lx[p] * X[Li[p]];
+      }
+    }
+    for (int k{0}; k < n; k++) {
+      b[perm[k]] = X[k];
+    }
+  }
+
+  // solve A x = b using the last pivoted factorisation (b)
+  void solve_pivoted(T *b) const {
+    for (int k{0}; k < n; k++) {
+      X[row_pivot[k]] = b[perm[k]];
+    }
+    // L y = P b
+    for (int j{0}; j < n; j++) {
+      for (int p{LUp[j]}; p < LUp[j + 1]; p++) {
+        X[LUi[p]] = X[LUi[p]] - LUx[p] * X[j];
+      }
+    }
+    // U x = y
+    for (int j{n - 1}; j >= 0; j--) {
+      X[j] = X[j] / Ux[Up[j + 1] - 1];
+      for (int p{Up[j]}; p < Up[j + 1] - 1; p++) {
+        X[Ui[p]] = X[Ui[p]] - Ux[p] * X[j];
+      }
+    }
+    for (int k{0}; k < n; k++) {
+      b[perm[k]] = X[k];
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,195 @@
+/* stats.cpp
+ * Implementation of the stats namespace and the counting operator new. The
+ * blocks of the threads form a list which only ever grows, so the totals can
+ * be read at any time without stopping the threads which are counting
+ *  Interface:      stats.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <atomic>   // list of blocks
+#include <chrono>   // timers
+#include <cstdlib>  // malloc, free
+#include <cstring>  // strlen
+#include <iostream> // JSON output
+#include <new>      // operator new, bad_alloc
+
+#include "stats.h" // interface
+
+#include "renderer.h" // buffered output
+
+namespace stats {
+atomic<bool> enabled{false};
+thread_local ThreadCounters *local{nullptr};
+
+namespace {
+// blocks of every thread which has counted anything
+atomic<ThreadCounters *> blocks{nullptr};
+
+const char *const counter_names[no_counters]{
+    "resistor_evaluations", "capacitor_evaluations", "inductor_evaluations",
+    "series_evaluations",   "parallel_evaluations",  "cache_hits",
+    "cache_misses",         "allocations",           "label_lookups",
+    "bytes_loaded",         "bytes_saved"};
+const char *const timer_names[no_timers]{
+    "load_project",      "save_project", "print_circuit_lib",
+    "evaluate_library",  "sweep_evaluate", "export_sweep",
+    "snapshot_evaluate", "sensitivity",  "montecarlo",
+    "transient"};
+
+// total of one count over every block (count of a block)
+template <class F> uint64_t sum(F count) {
+  uint64_t result{0};
+  for (ThreadCounters *block{blocks.load(memory_order_acquire)};
+       block != nullptr; block = block->next) {
+    result += count(*block).load(memory_order_relaxed);
+  }
+  return result;
+}
+
+// append a name padded to a column (renderer, name, width)
+void pad(Renderer &out, const char *text, const size_t &width) {
+  const size_t length{strlen(text)};
+  out << text;
+  for (size_t i{length}; i < width; i++) {
+    out << ' ';
+  }
+}
+} // namespace
+
+// make the block of this thread. It is allocated with malloc rather than new
+// so that making it is never counted as an allocation, and added to the front
+// of the list
+ThreadCounters *register_thread() {
+  void *memory{malloc(sizeof(ThreadCounters))};
+  if (memory == nullptr) {
+    throw bad_alloc();
+  }
+  ThreadCounters *block{new (memory) ThreadCounters{}};
+  block->next = blocks.load(memory_order_relaxed);
+  while (!blocks.compare_exchange_weak(block->next, block,
+                                       memory_order_release,
+                                       memory_order_relaxed)) {
+  }
+  local = block;
+  return block;
+}
+
+// start timing
+ScopedTimer::ScopedTimer(const timer &t)
+    : which{t}, active{enabled.load(memory_order_relaxed)} {
+  if (active) {
+    start = chrono::steady_clock::now();
+  }
+}
+
+// add the time to the timer
+ScopedTimer::~ScopedTimer() {
+  if (!active) {
+    return;
+  }
+  const uint64_t elapsed = chrono::duration_cast<chrono::nanoseconds>(
+                               chrono::steady_clock::now() - start)
+                               .count();
+  ThreadCounters *block{local != nullptr ? local : register_thread()};
+  add_to(block->calls[which], 1);
+  add_to(block->nanoseconds[which], elapsed);
+}
+
+// switch counting on or off
+void enable(const bool &on) { enabled.store(on, memory_order_relaxed); }
+
+// zero every counter and timer. Counts made by other threads at the same time
+// may be lost
+void reset() {
+  for (ThreadCounters *block{blocks.load(memory_order_acquire)};
+       block != nullptr; block = block->next) {
+    for (auto &it : block->counts) {
+      it.store(0, memory_order_relaxed);
+    }
+    for (int t{0}; t < no_timers; t++) {
+      block->calls[t].store(0, memory_order_relaxed);
+      block->nanoseconds[t].store(0, memory_order_relaxed);
+    }
+  }
+}
+
+// totals over every thread
+uint64_t total(const counter &which) {
+  return sum([&which](ThreadCounters &block) -> atomic<uint64_t> & {
+    return block.counts[which];
+  });
+}
+
+uint64_t total_calls(const timer &which) {
+  return sum([&which](ThreadCounters &block) -> atomic<uint64_t> & {
+    return block.calls[which];
+  });
+}
+
+uint64_t total_nanoseconds(const timer &which) {
+  return sum([&which](ThreadCounters &block) -> atomic<uint64_t> & {
+    return block.nanoseconds[which];
+  });
+}
+
+const char *name(const counter &which) { return counter_names[which]; }
+
+const char *name(const timer &which) { return timer_names[which]; }
+
+// print a table of the totals
+void print(Renderer &out) {
+  out << "\n--------Performance counters (" << (enabled ? "on" : "off")
+      << ")--------\n";
+  for (int c{0}; c < no_counters; c++) {
+    out << "  ";
+    pad(out, name((counter)c), 24);
+    out << (size_t)total((counter)c) << "\n";
+  }
+  out << "\n  ";
+  pad(out, "Timer", 24);
+  out << "Calls  Total/ms  Mean/us\n";
+  for (int t{0}; t < no_timers; t++) {
+    const uint64_t calls{total_calls((timer)t)};
+    const double nanoseconds = total_nanoseconds((timer)t);
+    out << "  ";
+    pad(out, name((timer)t), 24);
+    out << (size_t)calls << "  " << nanoseconds / 1e6 << "  "
+        << (calls > 0 ? nanoseconds / 1e3 / calls : 0) << "\n";
+  }
+  out << "\n";
+}
+
+// write the totals as one JSON object
+void write_json(ostream &os) {
+  Renderer out(os);
+  out << "{\"enabled\":" << (enabled ? "true" : "false") << ",\"counters\":{";
+  for (int c{0}; c < no_counters; c++) {
+    out << (c > 0 ? "," : "") << '"' << name((counter)c)
+        << "\":" << (size_t)total((counter)c);
+  }
+  out << "},\"timers\":{";
+  for (int t{0}; t < no_timers; t++) {
+    out << (t > 0 ? "," : "") << '"' << name((timer)t) << "\":{\"calls\":"
+        << (size_t)total_calls((timer)t)
+        << ",\"nanoseconds\":" << (size_t)total_nanoseconds((timer)t) << "}";
+  }
+  out << "}}\n";
+}
+} // namespace stats
+
+//-----------------------------------------------------------------------------
+//---allocation counting
+//-----------------------------------------------------------------------------
+void *operator new(size_t size) {
+  stats::add(stats::allocations);
+  if (void *p = malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw bad_alloc();
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
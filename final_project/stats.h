@@ -0,0 +1,116 @@
+/* stats.h
+ * Interface for the stats namespace of performance counters and timers. They
+ * are always compiled in and switched on and off while the program runs. Each
+ * thread counts into its own block, so counting is a load and a store with no
+ * locking or shared cache lines, and when collection is off it is one relaxed
+ * load of a flag. Blocks are never freed, so the totals include threads which
+ * have finished. Allocations are counted by replacing the global operator new
+ *  Implementation:  stats.cpp
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>   // counts read by other threads
+#include <chrono>   // timers
+#include <cstdint>  // fixed width integers
+#include <iostream> // JSON output
+
+#include "renderer.h" // buffered output
+
+namespace stats {
+// things which are counted
+enum counter : uint8_t {
+  resistor_evaluations,  // Component::get_impedance of each kind
+  capacitor_evaluations,
+  inductor_evaluations,
+  series_evaluations,    // circuits calculated rather than taken from cache
+  parallel_evaluations,
+  cache_hits,            // Circuit::get_impedance from the cache
+  cache_misses,
+  allocations,           // calls to operator new
+  label_lookups,         // finding a component or circuit by its label
+  bytes_loaded,          // project files read
+  bytes_saved,           // project files written
+  no_counters
+};
+// scopes which are timed
+enum timer : uint8_t {
+  load_project,
+  save_project,
+  print_circuit_lib,
+  evaluate_library,
+  sweep_evaluate,
+  export_sweep,
+  snapshot_evaluate,
+  sensitivity,
+  montecarlo,
+  transient,
+  no_timers
+};
+
+// counts of one thread
+struct ThreadCounters {
+  atomic<uint64_t> counts[no_counters];
+  atomic<uint64_t> calls[no_timers];
+  atomic<uint64_t> nanoseconds[no_timers];
+  ThreadCounters *next; // block of another thread
+};
+
+// whether counting is switched on
+extern atomic<bool> enabled;
+// block of this thread, nullptr until it first counts something
+extern thread_local ThreadCounters *local;
+// make the block of this thread
+ThreadCounters *register_thread();
+
+// add to a counter of this thread, only the owning thread writes to its
+// block (counter, amount)
+inline void add_to(atomic<uint64_t> &count, const uint64_t &amount) {
+  count.store(count.load(memory_order_relaxed) + amount,
+              memory_order_relaxed);
+}
+inline void add(const counter &which, const uint64_t &amount = 1) {
+  if (enabled.load(memory_order_relaxed)) {
+    ThreadCounters *block{local != nullptr ? local : register_thread()};
+    add_to(block->counts[which], amount);
+  }
+}
+
+// time the scope it is declared in, if counting is on when it starts
+class ScopedTimer {
+private:
+  timer which;
+  bool active;
+  chrono::steady_clock::time_point start;
+
+public:
+  // start timing (timer)
+  explicit ScopedTimer(const timer &);
+  // add the time to the timer
+  ~ScopedTimer();
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+};
+
+// switch counting on or off (on)
+void enable(const bool &);
+// zero every counter and timer
+void reset();
+// totals over every thread (counter/timer)
+uint64_t total(const counter &);
+uint64_t total_calls(const timer &);
+uint64_t total_nanoseconds(const timer &);
+// names used in the table and the JSON (counter/timer)
+const char *name(const counter &);
+const char *name(const timer &);
+
+// print a table of the totals (renderer)
+void print(Renderer &);
+// write the totals as a JSON object (stream)
+void write_json(ostream &);
+} // namespace stats
+
+#endif
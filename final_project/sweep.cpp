@@ -0,0 +1,266 @@
+/* sweep.cpp
+ * Implementation of Sweep class to evaluate the impedance of a circuit over
+ * many frequencies at once
+ *  Interface:      sweep.h
+ *  Author:         Dónal Murray
+ *  Date:           17/10/26
+ */
+
+#include <algorithm> // max
+#include <cmath>     // pow
+#include <map>       // map for shared subcircuits
+#include <vector>    // vector container
+
+#define _USE_MATH_DEFINES // M_PI
+#include <math.h>         // M_PI
+
+#include "circuit.h"      // circuit class
+#include "complexbatch.h" // batch complex arithmetic
+#include "stats.h"        // performance counters
+#include "sweep.h"        // class interface
+
+const size_t Sweep::block_size; // define static data member
+
+// compile the circuit into a postfix program
+Sweep::Sweep(const Circuit &circ) : stack_size{0}, register_count{0} {
+  map<const Circuit *, int> references; // number of parents of each circuit
+  map<const Circuit *, int> registers;  // register of each shared circuit
+  count_references(&circ, references);
+  compile(&circ, references, registers, 0);
+}
+
+// count the number of parents of every circuit below circ. Each circuit is
+// only descended into once so shared subcircuits are not counted twice
+void Sweep::count_references(const Circuit *circ,
+                             map<const Circuit *, int> &references) {
+  for (auto it : circ->get_subcircuits()) {
+    if (references[it]++ == 0) {
+      // first time this subcircuit has been seen
+      count_references(it, references);
+    }
+  }
+}
+
+// append the program for circ to the end of the program, with depth entries
+// already on the stack
+void Sweep::compile(const Circuit *circ,
+                    const map<const Circuit *, int> &references,
+                    map<const Circuit *, int> &registers, int depth) {
+  // the operands are pushed in the same order that get_impedance adds them
+  // (components first, then subcircuits) so the results are identical
+  int operands{0};
+  for (auto it : circ->get_components()) {
+    Instruction leaf{push_resistor, (int)values.size()};
+    switch (it->get_kind()) {
+    case component_kind::resistor:
+      break;
+    case component_kind::capacitor:
+      leaf.op = push_capacitor;
+      break;
+    case component_kind::inductor:
+      leaf.op = push_inductor;
+      break;
+    }
+    values.push_back(it->get_value());
+    leaves.push_back(it);
+    program.push_back(leaf);
+    operands++;
+    stack_size = max(stack_size, depth + operands);
+  }
+  for (auto it : circ->get_subcircuits()) {
+    auto reg = registers.find(it);
+    if (reg != registers.end()) {
+      // shared subcircuit which has already been evaluated
+      program.push_back({load, reg->second});
+    } else {
+      compile(it, references, registers, depth + operands);
+      if (references.at(it) > 1) {
+        // keep a copy for the other parents of this subcircuit
+        registers[it] = register_count;
+        program.push_back({store, register_count++});
+      }
+    }
+    operands++;
+    stack_size = max(stack_size, depth + operands);
+  }
+
+  if (dynamic_cast<const Parallel *>(circ) != nullptr) {
+    program.push_back({parallel, operands});
+  } else {
+    program.push_back({series, operands});
+  }
+  // an empty circuit still pushes a result
+  stack_size = max(stack_size, depth + 1);
+}
+
+// structure of arrays workspace: one block per stack entry and register
+Sweep::Workspace::Workspace(const Sweep &sweep)
+    : stack_re(sweep.stack_size * block_size),
+      stack_im(sweep.stack_size * block_size),
+      reg_re(sweep.register_count * block_size),
+      reg_im(sweep.register_count * block_size) {}
+
+// number of instructions in the compiled program
+size_t Sweep::get_program_size() const { return program.size(); }
+
+// components of the leaves of the program
+const vector<const Component *> &Sweep::get_leaf_components() const {
+  return leaves;
+}
+
+// evaluate the impedance at n frequencies
+void Sweep::evaluate(const double *freq, double *re, double *im,
+                     size_t n) const {
+  stats::ScopedTimer timer{stats::sweep_evaluate};
+  Workspace work(*this);
+  for (size_t start{0}; start < n; start += block_size) {
+    evaluate_block<false>(freq + start, values.data(), 0, re + start,
+                          im + start, min(block_size, n - start), work);
+  }
+}
+
+// evaluate the impedance at every frequency in the vector
+void Sweep::evaluate(const vector<double> &freq, vector<double> &re,
+                     vector<double> &im) const {
+  re.resize(freq.size());
+  im.resize(freq.size());
+  evaluate(freq.data(), re.data(), im.data(), freq.size());
+}
+
+// evaluate the impedance at one frequency for n sets of leaf values
+void Sweep::evaluate_values(const double &freq, const double *leaf_values,
+                            const size_t &stride, double *re, double *im,
+                            const size_t &n, Workspace &work) const {
+  for (size_t start{0}; start < n; start += block_size) {
+    evaluate_block<true>(&freq, leaf_values + start, stride, re + start,
+                         im + start, min(block_size, n - start), work);
+  }
+}
+
+// evaluate one block. Every instruction is a loop over the block, either
+// written out here for the compiler to vectorise or done by the batch complex
+// operations. Either the frequency (sweeps) or the component values (sets of
+// values) change along the block, which is fixed at compile time so that the
+// loops are the same as if they had been written out separately
+template <bool per_sample_values>
+void Sweep::evaluate_block(const double *freq, const double *leaf_values,
+                           const size_t &stride, double *re, double *im,
+                           const size_t &n, Workspace &work) const {
+  // frequency and leaf value for entry i of the block
+  auto frequency = [freq](const size_t &i) {
+    return per_sample_values ? freq[0] : freq[i];
+  };
+  auto value = [leaf_values, &stride](const int &leaf, const size_t &i) {
+    return per_sample_values ? leaf_values[leaf * stride + i]
+                             : leaf_values[leaf];
+  };
+  double *stack_re{work.stack_re.data()};
+  double *stack_im{work.stack_im.data()};
+  double *reg_re{work.reg_re.data()};
+  double *reg_im{work.reg_im.data()};
+  size_t sp{0}; // number of entries on the stack
+  for (auto &ins : program) {
+    double *top_re{stack_re + sp * block_size};
+    double *top_im{stack_im + sp * block_size};
+    switch (ins.op) {
+    case push_resistor: {
+      // Z = R
+      for (size_t i{0}; i < n; i++) {
+        top_re[i] = value(ins.arg, i);
+        top_im[i] = 0;
+      }
+      sp++;
+      break;
+    }
+    case push_capacitor: {
+      // Z = 1/jwC
+      for (size_t i{0}; i < n; i++) {
+        const double x{2 * M_PI * frequency(i) * value(ins.arg, i) / 1e6};
+        top_re[i] = 0;
+        top_im[i] = -x / (x * x);
+      }
+      sp++;
+      break;
+    }
+    case push_inductor: {
+      // Z = jwL
+      for (size_t i{0}; i < n; i++) {
+        top_re[i] = 0;
+        top_im[i] = 2 * M_PI * frequency(i) * value(ins.arg, i) / 1e6;
+      }
+      sp++;
+      break;
+    }
+    case series:
+    case parallel: {
+      if (ins.arg == 0) {
+        // empty circuit, sum of no impedances
+        for (size_t i{0}; i < n; i++) {
+          top_re[i] = 0;
+          top_im[i] = 0;
+        }
+        sp++;
+      }
+      const size_t count{ins.arg == 0 ? 1 : (size_t)ins.arg};
+      const ComplexSpan base{stack_re + (sp - count) * block_size,
+                             stack_im + (sp - count) * block_size, n};
+      const bool invert{ins.op == parallel};
+      for (size_t k{0}; k < count; k++) {
+        const ComplexSpan z{base.re + k * block_size, base.im + k * block_size,
+                            n};
+        if (invert && (ins.arg != 0)) {
+          batch::reciprocal(z, z);
+        }
+        if (k > 0) {
+          batch::add(base, z, base);
+        }
+      }
+      if (invert) {
+        batch::reciprocal(base, base);
+      }
+      sp -= count - 1;
+      break;
+    }
+    case store: {
+      const double *z_re{top_re - block_size};
+      const double *z_im{top_im - block_size};
+      double *r_re{reg_re + ins.arg * block_size};
+      double *r_im{reg_im + ins.arg * block_size};
+      for (size_t i{0}; i < n; i++) {
+        r_re[i] = z_re[i];
+        r_im[i] = z_im[i];
+      }
+      break;
+    }
+    case load: {
+      const double *r_re{reg_re + ins.arg * block_size};
+      const double *r_im{reg_im + ins.arg * block_size};
+      for (size_t i{0}; i < n; i++) {
+        top_re[i] = r_re[i];
+        top_im[i] = r_im[i];
+      }
+      sp++;
+      break;
+    }
+    }
+  }
+  // the impedance of the whole circuit is the only entry left on the stack
+  for (size_t i{0}; i < n; i++) {
+    re[i] = stack_re[i];
+    im[i] = stack_im[i];
+  }
+}
+
+// logarithmically spaced frequencies from start to end
+vector<double> log_spaced_frequencies(const double &start, const double &end,
+                                      const int &points) {
+  if ((start <= 0) || (end <= 0) || (points < 1)) {
+    throw(1);
+  }
+  vector<double> freq(points);
+  for (int i{0}; i < points; i++) {
+    freq[i] = points == 1 ? start
+                          : start * pow(end / start, (double)i / (points - 1));
+  }
+  return freq;
+}
@@ -0,0 +1,105 @@
+/* sweep.h
+ * Interface for Sweep class which flattens a series/parallel circuit tree into
+ * a linear postfix program and evaluates it over many frequencies at once
+ *  Implementation:  sweep.cpp
+ *  Author:          Dónal Murray
+ *  Date:            17/10/26
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <cstddef> // size_t
+#include <map>     // map for shared subcircuits
+#include <vector>  // vector container
+
+#include "circuit.h" // circuit class
+
+class Sweep {
+public:
+  class Workspace;
+
+private:
+  // instructions of the postfix program
+  enum op_code {
+    push_resistor,  // push Z of the resistor values[arg]
+    push_capacitor, // push Z of the capacitor values[arg]
+    push_inductor,  // push Z of the inductor values[arg]
+    series,         // replace the top arg entries with their sum
+    parallel,       // replace the top arg entries with 1/sum(1/Z)
+    store,          // copy the top entry into register arg (shared circuits)
+    load            // push a copy of register arg
+  };
+  struct Instruction {
+    op_code op;
+    int arg;
+  };
+
+  vector<Instruction> program;      // postfix program
+  vector<double> values;            // component values used by the program
+  vector<const Component *> leaves; // component each value came from
+  int stack_size;                   // maximum depth of the evaluation stack
+  int register_count;               // registers for shared subcircuits
+
+  // number of frequencies evaluated together, sized so the stack stays in
+  // cache while being long enough for the loops to vectorise
+  static const size_t block_size{256};
+
+  // count how many times each circuit is referenced (circuit, references)
+  void count_references(const Circuit *, map<const Circuit *, int> &);
+  // append the program for a circuit (circuit, references, registers, depth)
+  void compile(const Circuit *, const map<const Circuit *, int> &,
+               map<const Circuit *, int> &, int);
+  // evaluate one block of at most block_size frequencies, or of sets of
+  // values at one frequency (frequencies, values, stride between the values of
+  // each leaf, real parts, imaginary parts, n, workspace)
+  template <bool per_sample_values>
+  void evaluate_block(const double *, const double *, const size_t &,
+                      double *, double *, const size_t &, Workspace &) const;
+
+public:
+  // stack and registers for evaluating a block, which can be kept and reused
+  // so that repeated evaluations do not allocate
+  class Workspace {
+    friend class Sweep;
+
+  private:
+    vector<double> stack_re;
+    vector<double> stack_im;
+    vector<double> reg_re;
+    vector<double> reg_im;
+
+  public:
+    // workspace for a compiled circuit (sweep)
+    Workspace(const Sweep &);
+  };
+
+  // compile the circuit (circuit)
+  Sweep(const Circuit &);
+
+  // number of instructions in the compiled program
+  size_t get_program_size() const;
+  // components of the leaves of the program, in the order of their values. A
+  // component used in several places appears once for each use
+  const vector<const Component *> &get_leaf_components() const;
+
+  // evaluate the impedance at n frequencies (frequencies, real parts,
+  // imaginary parts, n)
+  void evaluate(const double *, double *, double *, size_t) const;
+  // evaluate the impedance at every frequency in the vector (frequencies,
+  // real parts, imaginary parts)
+  void evaluate(const vector<double> &, vector<double> &,
+                vector<double> &) const;
+  // evaluate the impedance at one frequency for n sets of leaf values, where
+  // values[k * stride + i] is the value of leaf k in set i (frequency,
+  // values, stride, real parts, imaginary parts, n, workspace)
+  void evaluate_values(const double &, const double *, const size_t &,
+                       double *, double *, const size_t &, Workspace &) const;
+};
+
+// logarithmically spaced frequencies from start to end (start, end, number of
+// frequencies)
+vector<double> log_spaced_frequencies(const double &, const double &,
+                                      const int &);
+
+#endif
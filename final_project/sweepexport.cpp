@@ -0,0 +1,262 @@
+/* sweepexport.cpp
+ * Implementation of sweep export. The calling thread compiles and evaluates
+ * the circuits and a writer thread formats and writes the results, handing
+ * two chunks back and forth so neither waits unless the other falls behind
+ *  Interface:      sweepexport.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <algorithm>          // min
+#include <condition_variable> // waiting for a chunk
+#include <exception>          // errors from the writer thread
+#include <fstream>            // file output
+#include <mutex>              // lock for the chunks
+#include <string>             // labels
+#include <thread>             // writer thread
+#include <vector>             // vector container
+
+#define _USE_MATH_DEFINES // M_PI
+#include <math.h>         // M_PI
+
+#include "sweepexport.h" // interface
+
+#include "circuit.h"      // circuit class
+#include "complexbatch.h" // batch modulus
+#include "renderer.h"     // buffered output
+#include "stats.h"        // performance counters
+#include "sweep.h"        // compiled circuits
+
+namespace {
+// number of frequencies evaluated and written together
+const size_t chunk_points{8192};
+
+// results for a chunk of frequencies of one circuit
+struct Chunk {
+  size_t circuit; // position in the list of circuits
+  size_t start;   // first frequency
+  size_t n;       // number of frequencies
+  vector<double> re;
+  vector<double> im;
+  vector<double> modulus;
+  vector<double> phase;
+};
+
+// two chunks, filled in turn by the evaluating thread and emptied in turn by
+// the writing thread
+class DoubleBuffer {
+private:
+  Chunk chunks[2];
+  bool full[2];        // chunk waiting to be written
+  bool finished;       // no more chunks will be filled
+  exception_ptr error; // thrown by the writer
+  mutex lock;
+  condition_variable changed;
+
+public:
+  DoubleBuffer() : full{false, false}, finished{false} {
+    for (auto &it : chunks) {
+      it.re.resize(chunk_points);
+      it.im.resize(chunk_points);
+      it.modulus.resize(chunk_points);
+      it.phase.resize(chunk_points);
+    }
+  }
+
+  // wait until a chunk has been written and return it to be filled again,
+  // rethrowing anything the writer threw (chunk number)
+  Chunk &to_fill(const size_t &i) {
+    unique_lock<mutex> guard{lock};
+    changed.wait(guard, [&]() { return !full[i] || error; });
+    if (error) {
+      rethrow_exception(error);
+    }
+    return chunks[i];
+  }
+  // hand a filled chunk to the writer (chunk number)
+  void filled(const size_t &i) {
+    {
+      lock_guard<mutex> guard{lock};
+      full[i] = true;
+    }
+    changed.notify_all();
+  }
+  // wait until a chunk has been filled and return it, nullptr once every
+  // chunk has been written (chunk number)
+  Chunk *to_write(const size_t &i) {
+    unique_lock<mutex> guard{lock};
+    changed.wait(guard, [&]() { return full[i] || finished; });
+    return full[i] ? &chunks[i] : nullptr;
+  }
+  // hand a written chunk back (chunk number)
+  void written(const size_t &i) {
+    {
+      lock_guard<mutex> guard{lock};
+      full[i] = false;
+    }
+    changed.notify_all();
+  }
+  // no more chunks will be filled
+  void finish() {
+    {
+      lock_guard<mutex> guard{lock};
+      finished = true;
+    }
+    changed.notify_all();
+  }
+  // stop the evaluating thread with the writer's error (error)
+  void fail(const exception_ptr &err) {
+    {
+      lock_guard<mutex> guard{lock};
+      error = err;
+    }
+    changed.notify_all();
+  }
+  // rethrow anything the writer threw
+  void check() {
+    lock_guard<mutex> guard{lock};
+    if (error) {
+      rethrow_exception(error);
+    }
+  }
+};
+
+// write the binary header, labels and frequencies (file, labels, frequencies)
+void write_binary_start(ofstream &file, const vector<string> &labels,
+                        const vector<double> &freq) {
+  SweepHeader header{{'A', 'C', 'S', 'W', 'E', 'E', 'P', '\0'},
+                     1,
+                     (uint32_t)labels.size(),
+                     freq.size(),
+                     0};
+  string label_text;
+  for (auto &it : labels) {
+    label_text.append(it);
+    label_text.push_back('\0');
+  }
+  // keep the columns aligned for readers which map the file
+  label_text.resize((label_text.size() + 7) / 8 * 8, '\0');
+  header.labels_size = label_text.size();
+  file.write((const char *)&header, sizeof(header));
+  file.write(label_text.data(), label_text.size());
+  file.write((const char *)freq.data(), freq.size() * sizeof(double));
+}
+
+// write a chunk of the CSV (output, label, frequencies, chunk)
+void write_csv_chunk(Renderer &out, const string &label, const double *freq,
+                     const Chunk &chunk) {
+  for (size_t i{0}; i < chunk.n; i++) {
+    out << label << ',';
+    out.write_exact(freq[chunk.start + i]);
+    out << ',';
+    out.write_exact(chunk.re[i]);
+    out << ',';
+    out.write_exact(chunk.im[i]);
+    out << ',';
+    out.write_exact(chunk.modulus[i]);
+    out << ',';
+    out.write_exact(chunk.phase[i]);
+    out << '\n';
+  }
+}
+
+// write the four columns of a chunk where they belong in the binary file
+// (file, start of the columns, number of frequencies, chunk)
+void write_binary_chunk(ofstream &file, const uint64_t &data_start,
+                        const uint64_t &no_points, const Chunk &chunk) {
+  const vector<double> *columns[4]{&chunk.re, &chunk.im, &chunk.modulus,
+                                   &chunk.phase};
+  for (uint64_t k{0}; k < 4; k++) {
+    file.seekp(data_start +
+               ((chunk.circuit * 4 + k) * no_points + chunk.start) *
+                   sizeof(double));
+    file.write((const char *)columns[k]->data(), chunk.n * sizeof(double));
+  }
+}
+} // namespace
+
+// evaluate every circuit at every frequency and write the results
+void export_sweep(const vector<Circuit *> &circuits, const vector<double> &freq,
+                  const string &filename, const sweep_format &format) {
+  stats::ScopedTimer timer{stats::export_sweep};
+  ofstream file(filename.c_str(), ios::binary);
+  if (!file.good()) {
+    throw(3);
+  }
+  // labels are formatted here rather than on the writer thread
+  vector<string> labels;
+  labels.reserve(circuits.size());
+  for (auto it : circuits) {
+    labels.push_back(it->get_label());
+  }
+  uint64_t data_start{0};
+  if (format == sweep_format::binary) {
+    write_binary_start(file, labels, freq);
+    data_start = file.tellp();
+  }
+
+  DoubleBuffer buffer;
+  thread writer([&]() {
+    try {
+      Renderer out(file);
+      if (format == sweep_format::csv) {
+        out << "circuit,frequency/Hz,re/ohm,im/ohm,modulus/ohm,phase/deg\n";
+      }
+      for (size_t next{0};; next++) {
+        const Chunk *chunk{buffer.to_write(next % 2)};
+        if (chunk == nullptr) {
+          break;
+        }
+        if (format == sweep_format::csv) {
+          write_csv_chunk(out, labels[chunk->circuit], freq.data(), *chunk);
+        } else {
+          write_binary_chunk(file, data_start, freq.size(), *chunk);
+        }
+        buffer.written(next % 2);
+        if (!file.good()) {
+          // disk full or similar
+          throw(3);
+        }
+      }
+      out.flush();
+      if (!file.good()) {
+        throw(3);
+      }
+    } catch (...) {
+      buffer.fail(current_exception());
+    }
+  });
+
+  try {
+    size_t next{0};
+    for (size_t c{0}; c < circuits.size(); c++) {
+      const Sweep sweep(*circuits[c]);
+      for (size_t start{0}; start < freq.size(); start += chunk_points) {
+        Chunk &chunk{buffer.to_fill(next % 2)};
+        chunk.circuit = c;
+        chunk.start = start;
+        chunk.n = min(chunk_points, freq.size() - start);
+        sweep.evaluate(freq.data() + start, chunk.re.data(), chunk.im.data(),
+                       chunk.n);
+        batch::modulus(ConstComplexSpan{chunk.re.data(), chunk.im.data(),
+                                        chunk.n},
+                       chunk.modulus.data());
+        batch::argument(ConstComplexSpan{chunk.re.data(), chunk.im.data(),
+                                         chunk.n},
+                        chunk.phase.data());
+        for (size_t i{0}; i < chunk.n; i++) {
+          chunk.phase[i] = chunk.phase[i] * 180 / M_PI;
+        }
+        buffer.filled(next % 2);
+        next++;
+      }
+    }
+    buffer.finish();
+  } catch (...) {
+    buffer.finish();
+    writer.join();
+    throw;
+  }
+  writer.join();
+  buffer.check();
+}
@@ -0,0 +1,46 @@
+/* sweepexport.h
+ * Interface for exporting frequency sweeps of many circuits: the frequency,
+ * Re(Z), Im(Z), |Z| and phase (degrees) of every circuit at every frequency,
+ * as CSV or as a packed binary columnar file. Each circuit is evaluated a
+ * chunk of frequencies at a time into one of two buffers while a background
+ * thread formats and writes the other, so evaluating and writing overlap and
+ * the memory used does not depend on the size of the export. Numbers are
+ * written in the shortest form which reads back exactly.
+ * The binary file is a header, the labels, the frequencies and then the
+ * columns of each circuit, each column no_points doubles in native byte order:
+ *    SweepHeader
+ *    labels       nul terminated, in circuit order, padded to 8 bytes
+ *    frequencies  no_points doubles
+ *    circuit 0    re, im, modulus, phase
+ *    circuit 1    ...
+ *  Implementation:  sweepexport.cpp
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef SWEEPEXPORT_H
+#define SWEEPEXPORT_H
+
+#include <cstdint> // fixed width integers
+#include <string>  // filenames
+#include <vector>  // vector container
+
+#include "circuit.h" // circuit class
+
+enum class sweep_format { csv, binary };
+
+// header of a binary sweep file, version 1
+struct SweepHeader {
+  char magic[8];        // "ACSWEEP" and a nul
+  uint32_t version;     // format version
+  uint32_t no_circuits; // number of circuits
+  uint64_t no_points;   // number of frequencies
+  uint64_t labels_size; // bytes of labels including padding
+};
+
+// evaluate every circuit at every frequency and write the results to a file
+// (circuits, frequencies, filename, format)
+void export_sweep(const vector<Circuit *> &, const vector<double> &,
+                  const string &, const sweep_format &);
+
+#endif
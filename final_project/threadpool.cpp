@@ -0,0 +1,121 @@
+/* threadpool.cpp
+ * Implementation of ThreadPool class, a work-stealing pool of worker threads
+ *  Interface:      threadpool.h
+ *  Author:         Dónal Murray
+ *  Date:           17/10/26
+ */
+
+#include <algorithm> // max
+
+#include "threadpool.h" // class interface
+
+// constructor - start one worker per queue
+ThreadPool::ThreadPool(unsigned threads)
+    : pending{0}, queued{0}, next_queue{0}, stopping{false} {
+  if (threads == 0) {
+    // one thread per core
+    threads = max(1u, thread::hardware_concurrency());
+  }
+  for (unsigned i{0}; i < threads; i++) {
+    queues.emplace_back(new Queue);
+  }
+  for (unsigned i{0}; i < threads; i++) {
+    workers.emplace_back(&ThreadPool::work, this, i);
+  }
+}
+
+// destructor - let the workers finish and join them
+ThreadPool::~ThreadPool() {
+  wait();
+  {
+    lock_guard<mutex> guard{sleep_lock};
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &it : workers) {
+    it.join();
+  }
+}
+
+// number of worker threads
+unsigned ThreadPool::size() const { return workers.size(); }
+
+// add a task to the queues in turn and wake a worker up to run it
+void ThreadPool::submit(function<void()> task) {
+  Queue &queue{*queues[next_queue++ % queues.size()]};
+  pending++;
+  {
+    lock_guard<mutex> guard{queue.lock};
+    queue.tasks.push_back(move(task));
+    queued++;
+  }
+  {
+    // take the lock so a worker cannot miss the notification
+    lock_guard<mutex> guard{sleep_lock};
+  }
+  wake.notify_one();
+}
+
+// take the newest task from queue i or, if it is empty, steal the oldest
+// task from one of the other queues. Returns false if there was nothing to do
+bool ThreadPool::run_task(const unsigned &i) {
+  function<void()> task;
+  for (unsigned j{0}; j < queues.size() && !task; j++) {
+    Queue &queue{*queues[(i + j) % queues.size()]};
+    lock_guard<mutex> guard{queue.lock};
+    if (!queue.tasks.empty()) {
+      if (j == 0) {
+        // own queue
+        task = move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        // steal
+        task = move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      queued--;
+    }
+  }
+  if (!task) {
+    return false;
+  }
+  task();
+  if (--pending == 0) {
+    lock_guard<mutex> guard{sleep_lock};
+    finished.notify_all();
+  }
+  return true;
+}
+
+// worker thread - run tasks until the pool is destroyed
+void ThreadPool::work(const unsigned &i) {
+  while (true) {
+    if (run_task(i)) {
+      continue;
+    }
+    // sleep until there is something in the queues
+    unique_lock<mutex> guard{sleep_lock};
+    wake.wait(guard, [this]() { return stopping || queued > 0; });
+    if (stopping && queued == 0) {
+      return;
+    }
+  }
+}
+
+// wait for all tasks to finish. The calling thread steals tasks too rather
+// than just sitting idle
+void ThreadPool::wait() {
+  while (pending > 0) {
+    if (!run_task(0)) {
+      // nothing left to steal, wait for the running tasks
+      unique_lock<mutex> guard{sleep_lock};
+      finished.wait(guard, [this]() { return pending == 0 || queued > 0; });
+    }
+  }
+}
+
+// pool shared by everything which evaluates in parallel
+ThreadPool &shared_pool() {
+  static ThreadPool pool;
+  return pool;
+}
@@ -0,0 +1,64 @@
+/* threadpool.h
+ * Interface for ThreadPool class, a work-stealing pool of worker threads
+ *  Implementation:  threadpool.cpp
+ *  Author:          Dónal Murray
+ *  Date:            17/10/26
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>             // count of unfinished tasks
+#include <condition_variable> // sleeping workers
+#include <deque>              // task queues
+#include <functional>         // function type for tasks
+#include <memory>             // unique_ptr
+#include <mutex>              // locks for the queues
+#include <thread>             // worker threads
+#include <vector>             // vector container
+
+using namespace std;
+
+class ThreadPool {
+private:
+  // each worker has its own queue which it takes tasks from the back of,
+  // idle workers steal from the front of the other queues
+  struct Queue {
+    mutex lock;
+    deque<function<void()>> tasks;
+  };
+
+  vector<unique_ptr<Queue>> queues; // one queue per worker
+  vector<thread> workers;           // worker threads
+  mutex sleep_lock;                 // protects sleeping and waiting
+  condition_variable wake;          // signalled when tasks are added
+  condition_variable finished;      // signalled when all tasks are done
+  atomic<int> pending;              // tasks submitted but not finished
+  atomic<int> queued;               // tasks waiting in the queues
+  atomic<unsigned> next_queue;      // round robin for submitted tasks
+  bool stopping;                    // set when the pool is destroyed
+
+  // run a task from queue i, or steal one from another queue (queue)
+  bool run_task(const unsigned &);
+  // worker thread main loop (queue)
+  void work(const unsigned &);
+
+public:
+  // constructor (number of threads, 0 for one per core)
+  ThreadPool(unsigned = 0);
+  // destructor - finishes outstanding tasks and joins the workers
+  ~ThreadPool();
+
+  // number of worker threads
+  unsigned size() const;
+  // add a task to the pool (task)
+  void submit(function<void()>);
+  // wait for every submitted task to finish, helping out in the meantime
+  void wait();
+};
+
+// pool with one thread per core, kept for the lifetime of the program and
+// shared by everything which evaluates in parallel
+ThreadPool &shared_pool();
+
+#endif
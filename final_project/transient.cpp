@@ -0,0 +1,253 @@
+/* transient.cpp
+ * Implementation of the TransientAnalysis class and Waveform. Every node
+ * equation is Kirchhoff's current law with each branch current written as
+ * i = G v + J, where J comes from the branch's voltage and current at the
+ * previous step. The voltage of the driven node is known, so its terms are
+ * moved to the right hand side and only the other nodes are solved for
+ *  Interface:      transient.h
+ *  Author:         Dónal Murray
+ *  Date:           18/10/26
+ */
+
+#include <algorithm> // count_if, upper_bound
+#include <cmath>     // sin, isfinite
+#include <cstdint>   // fixed width integers
+#include <vector>    // vector container
+
+#define _USE_MATH_DEFINES // M_PI
+#include <math.h>         // M_PI
+
+#include "transient.h" // class interface
+
+#include "component.h" // component base class
+#include "netlist.h"   // netlists
+#include "renderer.h"  // buffered output
+#include "stats.h"     // performance counters
+
+//-----------------------------------------------------------------------------
+//---Waveform
+//-----------------------------------------------------------------------------
+// voltage at a time
+double Waveform::at(const double &t) const {
+  switch (kind) {
+  case step:
+    return t >= 0 ? amplitude : 0;
+  case sine:
+    return amplitude * sin(2 * M_PI * frequency * t);
+  case piecewise_linear:
+    break;
+  }
+  if (times.empty()) {
+    return 0;
+  }
+  const size_t after =
+      upper_bound(times.begin(), times.end(), t) - times.begin();
+  if (after == 0) {
+    return voltages.front();
+  }
+  if (after == times.size()) {
+    return voltages.back();
+  }
+  const double fraction{(t - times[after - 1]) /
+                        (times[after] - times[after - 1])};
+  return voltages[after - 1] +
+         fraction * (voltages[after] - voltages[after - 1]);
+}
+
+//-----------------------------------------------------------------------------
+//---TransientAnalysis
+//-----------------------------------------------------------------------------
+// prepare a netlist for simulation with a voltage applied between two nodes
+TransientAnalysis::TransientAnalysis(const Netlist &net, const int &node,
+                                     const int &reference)
+    : port{node}, unknown{number_unknowns(net, node, reference)},
+      no_unknowns{(int)count_if(unknown.begin(), unknown.end(),
+                                [](const int &i) { return i >= 0; })},
+      unknown_node(no_unknowns),
+      ldl{no_unknowns, NodalAnalysis::pattern(net, unknown, true),
+          NodalAnalysis::pattern(net, unknown, false)},
+      factorised_step{0}, factorised_method{trapezoidal},
+      node_voltage(net.get_no_nodes(), 0), rhs(no_unknowns, 0) {
+  for (size_t i{0}; i < unknown.size(); i++) {
+    if (unknown[i] >= 0) {
+      unknown_node[unknown[i]] = i;
+    }
+  }
+  // the same branches as the pattern, in the same order
+  for (auto &it : net.get_branches()) {
+    if (it.from != it.to) {
+      branches.push_back(Branch{it.component->get_element(), it.from, it.to,
+                                unknown[it.from], unknown[it.to]});
+    }
+  }
+  conductance.assign(branches.size(), 0);
+  source.assign(branches.size(), 0);
+  voltage.assign(branches.size(), 0);
+  current.assign(branches.size(), 0);
+}
+
+// number the nodes connected to the reference node, leaving out the
+// reference and the node the voltage is applied to
+vector<int> TransientAnalysis::number_unknowns(const Netlist &net,
+                                               const int &node,
+                                               const int &reference) {
+  vector<int> numbering{NodalAnalysis::number_nodes(net, reference)};
+  if ((node < 0) || (node >= net.get_no_nodes()) || (node == reference)) {
+    throw(1);
+  }
+  const int removed{numbering[node]};
+  if (removed < 0) {
+    // no path between the nodes
+    throw(5);
+  }
+  numbering[node] = -1;
+  for (auto &it : numbering) {
+    if (it > removed) {
+      it--;
+    }
+  }
+  return numbering;
+}
+
+// factorise the nodal matrix for a step size
+void TransientAnalysis::prepare(const double &step_size, const method &rule) {
+  if ((step_size == factorised_step) && (rule == factorised_method)) {
+    return;
+  }
+  if (!(step_size > 0)) {
+    throw(1);
+  }
+  // matrix entries in the same order as the pattern
+  vector<double> values;
+  values.reserve(3 * branches.size());
+  for (size_t b{0}; b < branches.size(); b++) {
+    const Branch &branch{branches[b]};
+    const double value{branch.element.value};
+    double g{0};
+    switch (branch.element.kind) {
+    case component_kind::resistor:
+      g = 1 / value;
+      break;
+    case component_kind::capacitor:
+      g = (rule == trapezoidal ? 2 : 1) * value * 1e-6 / step_size;
+      break;
+    case component_kind::inductor:
+      g = step_size / ((rule == trapezoidal ? 2 : 1) * value * 1e-6);
+      break;
+    }
+    if (!isfinite(g)) {
+      // zero resistance or inductance, which nodal analysis cannot describe
+      throw(5);
+    }
+    conductance[b] = g;
+    if (branch.row_from >= 0) {
+      values.push_back(g);
+    }
+    if (branch.row_to >= 0) {
+      values.push_back(g);
+    }
+    if ((branch.row_from >= 0) && (branch.row_to >= 0)) {
+      values.push_back(-g);
+    }
+  }
+  if (!ldl.factorise(values)) {
+    // singular nodal matrix
+    factorised_step = 0;
+    throw(5);
+  }
+  factorised_step = step_size;
+  factorised_method = rule;
+}
+
+// return the network to rest
+void TransientAnalysis::reset() {
+  fill(voltage.begin(), voltage.end(), 0);
+  fill(current.begin(), current.end(), 0);
+  fill(node_voltage.begin(), node_voltage.end(), 0);
+}
+
+// advance one step with this voltage applied at the end of it
+double TransientAnalysis::step(const double &applied) {
+  if (factorised_step == 0) {
+    // no step size prepared
+    throw(1);
+  }
+  const bool trapezoidal_rule{factorised_method == trapezoidal};
+  fill(rhs.begin(), rhs.end(), 0);
+  for (size_t b{0}; b < branches.size(); b++) {
+    const Branch &branch{branches[b]};
+    const double g{conductance[b]};
+    // companion current source from the previous step
+    double j{0};
+    switch (branch.element.kind) {
+    case component_kind::resistor:
+      break;
+    case component_kind::capacitor:
+      j = trapezoidal_rule ? -(g * voltage[b] + current[b]) : -g * voltage[b];
+      break;
+    case component_kind::inductor:
+      j = trapezoidal_rule ? current[b] + g * voltage[b] : current[b];
+      break;
+    }
+    source[b] = j;
+    // current leaving each end, with the known voltage of the driven node
+    // moved to the right hand side
+    if (branch.row_from >= 0) {
+      rhs[branch.row_from] -= j;
+      if (branch.to == port) {
+        rhs[branch.row_from] += g * applied;
+      }
+    }
+    if (branch.row_to >= 0) {
+      rhs[branch.row_to] += j;
+      if (branch.from == port) {
+        rhs[branch.row_to] += g * applied;
+      }
+    }
+  }
+  ldl.solve(rhs.data());
+
+  for (int k{0}; k < no_unknowns; k++) {
+    node_voltage[unknown_node[k]] = rhs[k];
+  }
+  node_voltage[port] = applied;
+  double drawn{0};
+  for (size_t b{0}; b < branches.size(); b++) {
+    const Branch &branch{branches[b]};
+    voltage[b] = node_voltage[branch.from] - node_voltage[branch.to];
+    current[b] = conductance[b] * voltage[b] + source[b];
+    if (branch.from == port) {
+      drawn += current[b];
+    } else if (branch.to == port) {
+      drawn -= current[b];
+    }
+  }
+  return drawn;
+}
+
+// simulate from rest, writing each step as it is calculated so the waveform
+// is never held in memory
+void TransientAnalysis::run(const Waveform &applied, const double &step_size,
+                            const uint64_t &steps, const method &rule,
+                            Renderer &out) {
+  stats::ScopedTimer timer{stats::transient};
+  prepare(step_size, rule);
+  reset();
+  out << "time/s,voltage/V,current/A\n";
+  for (uint64_t n{1}; n <= steps; n++) {
+    // times are multiples of the step so that rounding does not build up
+    const double t{n * step_size};
+    const double v{applied.at(t)};
+    const double i{step(v)};
+    out.write_exact(t);
+    out << ',';
+    out.write_exact(v);
+    out << ',';
+    out.write_exact(i);
+    out << '\n';
+  }
+  out.flush();
+}
+
+// number of unknown node voltages
+int TransientAnalysis::get_no_unknowns() const { return no_unknowns; }
@@ -0,0 +1,105 @@
+/* transient.h
+ * Interface for the TransientAnalysis class, which simulates the response of
+ * a netlist over time to a voltage applied between two of its nodes. Each
+ * capacitor and inductor is replaced at every step by its companion model, a
+ * conductance in parallel with a current source set by the previous step
+ * (trapezoidal rule or backward Euler):
+ *    capacitor  G = 2C/h or C/h      inductor  G = h/2L or h/L
+ * The conductances only depend on the step size, so the nodal matrix is
+ * factorised once with the sparse LDL^T in sparseldl.h and each step is one
+ * solve with a new right hand side, with no allocation. The network starts at
+ * rest, with every voltage and current zero before the first step. Values
+ * are in ohms, microfarads and microhenries as for the rest of the program,
+ * and times in seconds
+ *  Implementation:  transient.cpp
+ *  Author:          Dónal Murray
+ *  Date:            18/10/26
+ */
+
+#ifndef TRANSIENT_H
+#define TRANSIENT_H
+
+#include <cstdint> // fixed width integers
+#include <vector>  // vector container
+
+#include "component.h" // component base class
+#include "netlist.h"   // netlists
+#include "renderer.h"  // buffered output
+#include "sparseldl.h" // sparse factorisation
+
+// voltage applied to a network
+struct Waveform {
+  enum shape {
+    step,            // amplitude from t = 0
+    sine,            // amplitude sin(2 pi frequency t)
+    piecewise_linear // straight lines between (times, voltages)
+  };
+  shape kind;
+  double amplitude;
+  double frequency;
+  vector<double> times;    // increasing
+  vector<double> voltages; // voltage at each time
+
+  // voltage at a time, holding the first and last voltages of a piecewise
+  // linear waveform outside its times (time)
+  double at(const double &) const;
+};
+
+class TransientAnalysis {
+public:
+  enum method { trapezoidal, backward_euler };
+
+private:
+  // two terminal branch of the netlist
+  struct Branch {
+    Element element;
+    int from; // nodes
+    int to;
+    int row_from; // unknowns of the nodes, -1 if the voltage is known
+    int row_to;
+  };
+
+  int port;                    // node the voltage is applied to
+  vector<int> unknown;         // unknown of each node, -1 if it is known
+  int no_unknowns;             // number of node voltages solved for
+  vector<int> unknown_node;    // node of each unknown
+  vector<Branch> branches;     // branches which are not loops
+  SparseLDL<double> ldl;       // factorisation of the nodal matrix
+  double factorised_step;      // step size and method of the factorisation
+  method factorised_method;
+  vector<double> conductance;  // companion conductance of each branch
+  vector<double> source;       // companion current source of each branch
+  vector<double> voltage;      // voltage across each branch
+  vector<double> current;      // current through each branch, from to to
+  vector<double> node_voltage; // voltage of every node
+  vector<double> rhs;          // right hand side, then unknown voltages
+
+  // number the nodes connected to the reference node, leaving out the
+  // reference and the node the voltage is applied to (netlist, node,
+  // reference node)
+  static vector<int> number_unknowns(const Netlist &, const int &,
+                                     const int &);
+
+public:
+  // prepare a netlist for simulation with a voltage applied between two nodes
+  // (netlist, node, reference node). The netlist is not needed afterwards
+  TransientAnalysis(const Netlist &, const int &, const int &);
+
+  // factorise the nodal matrix for a step size, unless it already is (step
+  // size, method)
+  void prepare(const double &, const method &);
+  // return the network to rest
+  void reset();
+  // advance one step of the prepared size with this voltage applied at the
+  // end of it, returning the current drawn from the source (voltage)
+  double step(const double &);
+  // simulate from rest, writing a "time,voltage,current" line for each step
+  // as it is calculated (waveform, step size, steps, method, output)
+  void run(const Waveform &, const double &, const uint64_t &, const method &,
+           Renderer &);
+
+  // number of unknown node voltages
+  int get_no_unknowns() const;
+};
+
+#endif